@@ -1,11 +1,15 @@
 #include "qos/atomic.h"
+#include "qos/batch.h"
 #include "qos/event.h"
 #include "qos/divide.h"
 #include "qos/interrupt.h"
 #include "qos/io.h"
 #include "qos/mutex.h"
+#include "qos/notify.h"
 #include "qos/parallel.h"
+#include "qos/pool.h"
 #include "qos/queue.h"
+#include "qos/semaphore.h"
 #include "qos/spsc_queue.h"
 #include "qos/task.h"
 #include "qos/time.h"
@@ -34,7 +38,14 @@
 
 struct qos_event_t* g_trigger_event;
 struct qos_event_t* g_event;
+struct qos_event_t* g_broadcast_event;
+struct qos_task_t* g_notified_task;
 struct qos_queue_t* g_queue;
+struct qos_queue_t* g_isr_queue;
+struct qos_queue_t* g_pool_queue;
+struct qos_pool_t* g_pool;
+struct qos_semaphore_t* g_batch_semaphore;
+struct qos_event_t* g_batch_reply_event;
 struct qos_spsc_queue_t* g_spsc_queue;
 struct qos_mutex_t* g_mutex;
 struct qos_condition_var_t* g_cond_var;
@@ -49,6 +60,9 @@ bool repeating_timer_isr(repeating_timer_t* timer) {
   qos_roll_back_atomic_from_isr();
   ++g_trigger_count;
   qos_signal_event_from_isr(g_trigger_event);
+
+  int32_t count = g_trigger_count;
+  qos_write_queue_from_isr(g_isr_queue, &count, sizeof(count));
   return true;
 }
 
@@ -83,6 +97,24 @@ void do_signal_event_task() {
   qos_sleep(1000000);
 }
 
+void do_broadcast_event_task() {
+  qos_signal_event(g_broadcast_event);
+  qos_sleep(1000000);
+}
+
+void do_await_broadcast_event_task() {
+  qos_await_event(g_broadcast_event, QOS_NO_TIMEOUT);
+}
+
+void do_notify_task() {
+  qos_increment_task_notify(g_notified_task);
+  qos_sleep(500000);
+}
+
+void do_await_notify_task() {
+  qos_await_notify_count(false, QOS_NO_TIMEOUT);
+}
+
 void do_producer_task1() {
   qos_write_queue(g_queue, "hello", 6, QOS_NO_TIMEOUT);
 }
@@ -106,6 +138,52 @@ void do_consumer_task2() {
   }
 }
 
+void do_isr_queue_consumer_task() {
+  for (;;) {
+    int32_t count;
+    qos_read_queue(g_isr_queue, &count, sizeof(count), QOS_NO_TIMEOUT);
+    assert(count > 0);
+  }
+}
+
+void do_batch_release_and_await_task() {
+  qos_batch_op_t ops[] = {
+    { QOS_BATCH_RELEASE_SEMAPHORE, g_batch_semaphore, NULL, 1 },
+    { QOS_BATCH_AWAIT_EVENT, g_batch_reply_event, NULL, 0 },
+  };
+
+  for (;;) {
+    bool result = qos_call_batch(ops, count_of(ops), QOS_NO_TIMEOUT);
+    assert(result);
+    qos_sleep(100000);
+  }
+}
+
+void do_batch_reply_task() {
+  for (;;) {
+    qos_acquire_semaphore(g_batch_semaphore, 1, QOS_NO_TIMEOUT);
+    qos_signal_event(g_batch_reply_event);
+  }
+}
+
+void do_pool_alloc_task() {
+  for (;;) {
+    char* block = qos_allocate_pool_block(g_pool, QOS_NO_TIMEOUT);
+    strcpy(block, "pooled");
+    qos_write_queue(g_pool_queue, &block, sizeof(block), QOS_NO_TIMEOUT);
+    qos_sleep(1000);
+  }
+}
+
+void do_pool_free_task() {
+  for (;;) {
+    char* block;
+    qos_read_queue(g_pool_queue, &block, sizeof(block), QOS_NO_TIMEOUT);
+    assert(strcmp(block, "pooled") == 0);
+    qos_free_pool_block(g_pool, block);
+  }
+}
+
 void do_spsc_producer_task() {
   qos_write_spsc_queue(g_spsc_queue, "hello", 6, 6, QOS_NO_TIMEOUT);
   qos_sleep(200);
@@ -240,7 +318,8 @@ void do_interp_task1() {
 }
 
 void do_interp_task2() {
-  qos_save_context(QOS_SAVE_INTERP_REGS);
+  static qos_interp_context_t interp_contexts[2];
+  qos_save_context_with_storage(QOS_SAVE_INTERP_REGS, interp_contexts);
   interp0_hw->accum[0] = 2;
   interp0_hw->accum[1] = 2;
   interp0_hw->base[0] = 2;
@@ -285,7 +364,13 @@ void QOS_INITIALIZATION init_core0() {
   qos_new_task(2, do_stdio_echo_task, 1024);
   qos_new_task(1, do_await_event_task, 1024);
   qos_new_task(1, do_signal_event_task, 1024);
+  qos_new_task(1, do_await_broadcast_event_task, 1024);
+  qos_new_task(1, do_await_broadcast_event_task, 1024);
+  g_notified_task = qos_new_task(1, do_await_notify_task, 1024);
   qos_new_task(100, do_lock_core_mutex_task1, 1024);
+  qos_new_task(1, do_isr_queue_consumer_task, 1024);
+  qos_new_task(1, do_batch_reply_task, 1024);
+  qos_new_task(1, do_pool_alloc_task, 1024);
 
   qos_protect_flash();
 }
@@ -301,8 +386,13 @@ void QOS_INITIALIZATION init_core1() {
   qos_new_task(1, do_interp_task2, 1024);
   qos_new_task(1, do_divide_task1, 1024);
   qos_new_task(1, do_divide_task2, 1024);
+  qos_new_task(1, do_broadcast_event_task, 1024);
+  qos_new_task(1, do_notify_task, 1024);
 
   qos_new_task(100, do_lock_core_mutex_task2, 1024);
+  qos_new_task(1, do_isr_queue_consumer_task, 1024);
+  qos_new_task(1, do_batch_release_and_await_task, 1024);
+  qos_new_task(1, do_pool_free_task, 1024);
 
   qos_protect_flash();
 }
@@ -322,12 +412,19 @@ int QOS_INITIALIZATION main() {
   recursive_mutex_init(&g_lock_core_recursive_mutex);
 
   g_queue = qos_new_queue(100);
+  g_isr_queue = qos_new_queue(4 * sizeof(int32_t));
+  g_pool_queue = qos_new_queue(4 * sizeof(char*));
+  g_pool = qos_new_pool(4, 16, true);
   g_spsc_queue = qos_new_spsc_queue(100, get_core_num(), 1 - get_core_num());
 
   g_mutex = qos_new_mutex(QOS_AUTO_PRIORITY_CEILING);
   g_cond_var = qos_new_condition_var(g_mutex);
 
   g_event = qos_new_event(0);
+  g_broadcast_event = qos_new_event_with_mode(0, QOS_EVENT_AUTO_RESET_ALL);
+
+  g_batch_semaphore = qos_new_semaphore(0);
+  g_batch_reply_event = qos_new_event(0);
 
   qos_start_tasks(init_core0, init_core1);
 
@@ -0,0 +1,49 @@
+#ifndef QOS_ATOMIC_S_H
+#define QOS_ATOMIC_S_H
+
+// Macros for application-defined atomic routines, which are rolled back on context switch and by
+// qos_roll_back_atomic_from_isr() just like those in atomic.S. All of a program's atomic routines must be
+// between QOS_ATOMIC_REGION_BEGIN and QOS_ATOMIC_REGION_END, which may each appear only once in a program.
+//
+//        QOS_ATOMIC_REGION_BEGIN
+//
+//        // int32_t my_atomic_sub(qos_atomic32_t* atomic, int32_t subtrahend)
+//        QOS_ATOMIC_ROUTINE my_atomic_sub
+// 0:     LDR     R3, [R0]
+//        SUBS    R3, R3, R1
+// 1:     STR     R3, [R0]      // byte offset 24
+//        MOVS    R0, R3
+//        BX      LR
+//
+//        QOS_ATOMIC_REGION_END
+//
+// Local label 0 marks where the routine restarts and local label 1 its commit instruction, which must be within 22
+// bytes of label 0. At most 6 more bytes may follow label 1. Until the commit instruction has executed, the routine
+// may be restarted from label 0 any number of times, so it must not modify its parameter registers before then,
+// nor store anywhere but memory that no other task reads before the commit, such as the inactive slot of a
+// qos_atomic64_t. Likewise, an exit before label 1 must not modify R0; branch to one outside the region instead.
+
+.MACRO QOS_ATOMIC_REGION_BEGIN
+.SECTION .time_critical.qos.user_atomic
+.SYNTAX UNIFIED
+.BALIGN 32
+.GLOBAL qos_user_atomic_start
+qos_user_atomic_start:
+.ENDM
+
+.MACRO QOS_ATOMIC_ROUTINE name
+.BALIGN 32
+.GLOBAL \name
+.TYPE \name, %function
+        B       0f
+.SPACE  22 - (1f - 0f)
+\name:
+.ENDM
+
+.MACRO QOS_ATOMIC_REGION_END
+.BALIGN 32
+.GLOBAL qos_user_atomic_end
+qos_user_atomic_end:
+.ENDM
+
+#endif  // QOS_ATOMIC_S_H
@@ -5,10 +5,39 @@
 
 QOS_BEGIN_EXTERN_C
 
+// Free running indices of a ring buffer, the capacity of which should be a power of two. Writers reserve elements
+// by advancing head. Once elements are consumed, they are released for reuse by advancing limit, which is initially
+// the capacity.
+typedef struct qos_atomic_ring_t {
+  qos_atomic32_t head;
+  qos_atomic32_t limit;
+} qos_atomic_ring_t;
+
+// Return the new value.
 int32_t qos_atomic_add(qos_atomic32_t* atomic, int32_t addend);
 int32_t qos_atomic_xor(qos_atomic32_t* atomic, int32_t bitmask);
+
+// Return the original value.
 int32_t qos_atomic_compare_and_set(qos_atomic32_t* atomic, int32_t expected, int32_t new_value);
 void* qos_atomic_compare_and_set_ptr(qos_atomic_ptr_t* atomic, void* expected, void* new_value);
+void* qos_atomic_exchange_ptr(qos_atomic_ptr_t* atomic, void* new_value);
+int32_t qos_atomic_fetch_or(qos_atomic32_t* atomic, int32_t bitmask);
+int32_t qos_atomic_fetch_and(qos_atomic32_t* atomic, int32_t bitmask);
+
+// Increments unless the value is already at least limit. Returns the original value.
+int32_t qos_atomic_bounded_increment(qos_atomic32_t* atomic, int32_t limit);
+
+// Singly linked LIFO in which the first word of each node points to the next node. Pop returns null if empty.
+void qos_atomic_push(qos_atomic_ptr_t* head, void* node);
+void* qos_atomic_pop(qos_atomic_ptr_t* head);
+
+// Reserves count elements, returning false if there is not room. On success, index is the free running index of the
+// first reserved element.
+bool qos_atomic_reserve_ring(qos_atomic_ring_t* ring, int32_t count, int32_t* index);
+
+// Only these may access a qos_atomic64_t.
+int64_t qos_atomic_load64(qos_atomic64_t* atomic);
+void qos_atomic_store64(qos_atomic64_t* atomic, int64_t value);
 
 QOS_END_EXTERN_C
 
@@ -32,6 +32,13 @@
 typedef volatile int32_t qos_atomic32_t;
 typedef void* volatile qos_atomic_ptr_t;
 
+// A 64-bit store is made to the inactive slot and then published by a single 32-bit store to active, so it cannot be
+// observed half done. Zero initialized, it holds zero.
+typedef struct qos_atomic64_t {
+  volatile int64_t slots[2];
+  volatile int32_t active;  // byte offset of the current slot: 0 or 8
+} qos_atomic64_t;
+
 // <-1: Absolute time in us, starting at INT64_MIN
 //  -1: Special value meaning no timeout
 //   0: Special value usually meaning return immediately rather than block
@@ -0,0 +1,152 @@
+#include "batch.h"
+
+#include "core_migrator.h"
+#include "event.internal.h"
+#include "mutex.internal.h"
+#include "queue.internal.h"
+#include "semaphore.internal.h"
+#include "svc.h"
+#include "task.internal.h"
+#include "time.h"
+
+#include <algorithm>
+
+static int32_t QOS_HANDLER_MODE object_core(const qos_batch_op_t& op) {
+  switch (op.kind) {
+  case QOS_BATCH_RELEASE_MUTEX:
+  case QOS_BATCH_ACQUIRE_MUTEX:
+    return ((qos_mutex_t*) op.object)->core;
+  case QOS_BATCH_RELEASE_SEMAPHORE:
+  case QOS_BATCH_ACQUIRE_SEMAPHORE:
+    return ((qos_semaphore_t*) op.object)->core;
+  case QOS_BATCH_SIGNAL_EVENT:
+  case QOS_BATCH_AWAIT_EVENT:
+    return ((qos_event_t*) op.object)->core;
+  case QOS_BATCH_WRITE_QUEUE:
+  case QOS_BATCH_READ_QUEUE:
+    return ((qos_queue_t*) op.object)->core;
+  }
+  assert(false);
+  return -1;
+}
+
+// Only the final operation of a batch may be one that might block.
+static bool QOS_HANDLER_MODE may_block(const qos_batch_op_t& op) {
+  return op.kind >= QOS_BATCH_ACQUIRE_MUTEX || op.kind == QOS_BATCH_WRITE_QUEUE;
+}
+
+static qos_task_state_t QOS_HANDLER_MODE batch_op_supervisor(qos_supervisor_t* supervisor, const qos_batch_op_t& op,
+                                                             qos_time_t timeout) {
+  switch (op.kind) {
+  case QOS_BATCH_RELEASE_MUTEX:
+    return qos_internal_release_mutex_supervisor((qos_mutex_t*) op.object);
+  case QOS_BATCH_RELEASE_SEMAPHORE:
+    return qos_internal_release_semaphore_supervisor((qos_semaphore_t*) op.object, op.count);
+  case QOS_BATCH_SIGNAL_EVENT:
+    return qos_internal_signal_event_supervisor((qos_event_t*) op.object);
+  case QOS_BATCH_WRITE_QUEUE:
+    return qos_internal_write_queue_supervisor(supervisor, (qos_queue_t*) op.object, op.data, op.count, timeout);
+  case QOS_BATCH_ACQUIRE_MUTEX:
+    return qos_internal_acquire_mutex_supervisor((qos_mutex_t*) op.object, timeout);
+  case QOS_BATCH_ACQUIRE_SEMAPHORE:
+    return qos_internal_acquire_semaphore_supervisor((qos_semaphore_t*) op.object, op.count, timeout);
+  case QOS_BATCH_AWAIT_EVENT:
+    return qos_internal_await_event_supervisor((qos_event_t*) op.object, timeout);
+  case QOS_BATCH_READ_QUEUE:
+    return qos_internal_read_queue_supervisor(supervisor, (qos_queue_t*) op.object, op.data, op.count, timeout);
+  }
+  assert(false);
+  return QOS_TASK_RUNNING;
+}
+
+// While busy, ISRs leave a queue alone so cannot fill it between checking that writes fit and making them.
+static void QOS_HANDLER_MODE set_written_queues_busy(const qos_batch_op_t* ops, int32_t num_ops, bool busy) {
+  __dmb();
+  for (auto i = 0; i < num_ops; ++i) {
+    if (ops[i].kind == QOS_BATCH_WRITE_QUEUE) {
+      ((qos_queue_t*) ops[i].object)->busy = busy;
+    }
+  }
+  __dmb();
+}
+
+// Several writes might be to the same queue so the bytes written to each queue are totalled.
+static bool QOS_HANDLER_MODE queue_writes_fit(const qos_batch_op_t* ops, int32_t num_ops) {
+  for (auto i = 0; i < num_ops; ++i) {
+    if (ops[i].kind != QOS_BATCH_WRITE_QUEUE) {
+      continue;
+    }
+
+    auto queue = (qos_queue_t*) ops[i].object;
+    int32_t size = 0;
+    for (auto j = 0; j < num_ops; ++j) {
+      if (ops[j].kind == QOS_BATCH_WRITE_QUEUE && ops[j].object == queue) {
+        size += ops[j].count;
+      }
+    }
+
+    if (size > queue->capacity - queue->count) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static qos_task_state_t QOS_HANDLER_MODE call_batch_supervisor(const qos_batch_op_t* ops, int32_t num_ops,
+                                                               qos_time_t timeout) {
+  auto supervisor = qos_internal_get_supervisor();
+
+  // Queue writes other than the final operation cannot block so, if any would not fit, the batch fails before any
+  // operation takes effect.
+  set_written_queues_busy(ops, num_ops - 1, true);
+  if (!queue_writes_fit(ops, num_ops - 1)) {
+    set_written_queues_busy(ops, num_ops - 1, false);
+    qos_current_supervisor_call_result(supervisor, false);
+    return QOS_TASK_RUNNING;
+  }
+
+  // Task states are ordered so the combined state is the most severe of any operation: if any readied a task of
+  // higher priority, the current task yields once, after the final operation, and if the final operation blocks,
+  // the current task blocks.
+  auto task_state = QOS_TASK_RUNNING;
+  for (auto i = 0; i < num_ops - 1; ++i) {
+    task_state = std::max(task_state, batch_op_supervisor(supervisor, ops[i], 0));
+  }
+  set_written_queues_busy(ops, num_ops - 1, false);
+
+  auto& last = ops[num_ops - 1];
+  if (!may_block(last)) {
+    task_state = std::max(task_state, batch_op_supervisor(supervisor, last, 0));
+    qos_current_supervisor_call_result(supervisor, true);
+  } else {
+    // Earlier operations may have set the call's result.
+    qos_current_supervisor_call_result(supervisor, false);
+    task_state = std::max(task_state, batch_op_supervisor(supervisor, last, timeout));
+  }
+
+  return task_state;
+}
+
+bool qos_call_batch(const qos_batch_op_t* ops, int32_t num_ops, qos_time_t timeout) {
+  assert(num_ops > 0);
+  qos_normalize_time(&timeout);
+
+  auto core = object_core(ops[0]);
+  for (auto i = 0; i < num_ops; ++i) {
+    auto& op = ops[i];
+    assert(object_core(op) == core);
+    assert(op.kind < QOS_BATCH_ACQUIRE_MUTEX || i == num_ops - 1);
+    assert(op.count >= 0);
+    assert((op.kind != QOS_BATCH_WRITE_QUEUE && op.kind != QOS_BATCH_READ_QUEUE) ||
+           op.count <= ((qos_queue_t*) op.object)->capacity);
+  }
+
+  // Queue operations return without blocking on zero timeout; the others require non-zero timeout.
+  auto& last = ops[num_ops - 1];
+  assert(timeout != 0 || last.kind < QOS_BATCH_ACQUIRE_MUTEX || last.kind == QOS_BATCH_READ_QUEUE);
+
+  qos_core_migrator migrator(core);
+
+  return qos_call_supervisor_regs(call_batch_supervisor, ops, num_ops, timeout);
+}
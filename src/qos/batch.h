@@ -0,0 +1,39 @@
+#ifndef QOS_BATCH_H
+#define QOS_BATCH_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+typedef enum qos_batch_op_kind_t {
+  // May appear anywhere in a batch.
+  QOS_BATCH_RELEASE_MUTEX,        // object is a mutex owned by the calling task
+  QOS_BATCH_RELEASE_SEMAPHORE,    // object is a semaphore; count is the count to release
+  QOS_BATCH_SIGNAL_EVENT,         // object is an event
+  QOS_BATCH_WRITE_QUEUE,          // object is a queue; count bytes from data. Blocks only if the final operation.
+
+  // May block so only the final operation of a batch may be one of these.
+  QOS_BATCH_ACQUIRE_MUTEX,        // object is a mutex
+  QOS_BATCH_ACQUIRE_SEMAPHORE,    // object is a semaphore; count is the count to acquire
+  QOS_BATCH_AWAIT_EVENT,          // object is an event
+  QOS_BATCH_READ_QUEUE,           // object is a queue; count bytes to data
+} qos_batch_op_kind_t;
+
+typedef struct qos_batch_op_t {
+  qos_batch_op_kind_t kind;
+  void* object;
+  void* data;
+  int32_t count;
+} qos_batch_op_t;
+
+// Performs a sequence of operations on synchronization objects, all with affinity to the same core, in a single
+// supervisor call. The operations are atomic with respect to other tasks and the supervisor makes one scheduling
+// decision once all are done. Only the final operation may block, in which case timeout applies to it; timeout must
+// not be zero if it acquires a mutex or semaphore or awaits an event. If a queue write other than the final operation
+// would not fit, returns false without performing any operation. Otherwise returns the result of the final operation
+// or true if it does not block.
+bool qos_call_batch(const qos_batch_op_t* ops, int32_t num_ops, qos_time_t timeout);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_BATCH_H
@@ -0,0 +1,164 @@
+#include "bus.h"
+#include "bus.internal.h"
+
+#include "atomic.h"
+#include "core_migrator.h"
+#include "queue.h"
+
+#include "hardware/sync.h"
+
+static_assert(sizeof(qos_bus_buffer_t) == 16);
+static_assert(QOS_BUS_POOL_BUFFER_SIZE(1, 0) == sizeof(void*) + sizeof(qos_bus_buffer_t));
+
+static qos_bus_buffer_t* get_buffer(void* data) {
+  return ((qos_bus_buffer_t*) data) - 1;
+}
+
+//////// Pool ////////
+
+qos_bus_pool_t* QOS_INITIALIZATION qos_new_bus_pool(int32_t count, int32_t buffer_size) {
+  auto pool = new qos_bus_pool_t;
+  qos_init_bus_pool(pool, new char[QOS_BUS_POOL_BUFFER_SIZE(count, buffer_size)], count, buffer_size);
+  return pool;
+}
+
+void QOS_INITIALIZATION qos_init_bus_pool(qos_bus_pool_t* pool, void* buffer, int32_t count, int32_t buffer_size) {
+  assert(count > 0);
+  assert((uintptr_t(buffer) & 7) == 0);
+
+  pool->core = get_core_num();
+
+  // Buffers are followed by the free queue's storage, which initially holds every buffer.
+  auto stride = int32_t(sizeof(qos_bus_buffer_t)) + ((buffer_size + 7) & ~7);
+  auto free_storage = (void**) ((char*) buffer + count * stride);
+  qos_init_queue(&pool->free, free_storage, count * sizeof(void*));
+
+  for (auto i = 0; i < count; ++i) {
+    auto header = (qos_bus_buffer_t*) ((char*) buffer + i * stride);
+    header->pool = pool;
+    free_storage[i] = header + 1;
+  }
+  pool->free.count = pool->free.capacity;
+}
+
+void* qos_acquire_bus_buffer(qos_bus_pool_t* pool, qos_time_t timeout) {
+  void* data;
+  if (!qos_read_queue(&pool->free, &data, sizeof(data), timeout)) {
+    return nullptr;
+  }
+
+  auto buffer = get_buffer(data);
+  for (auto core = 0; core < NUM_CORES; ++core) {
+    buffer->refs[core] = 0;
+  }
+  buffer->refs[get_core_num()] = 1;
+  buffer->cores_remaining = 1;
+
+  return data;
+}
+
+void qos_release_bus_buffer(void* data) {
+  auto buffer = get_buffer(data);
+
+  // Releasing on a core holding no reference would strand the buffer or free it early.
+  auto core = get_core_num();
+  assert(buffer->refs[core] > 0);
+
+  if (qos_atomic_add(&buffer->refs[core], -1) != 0) {
+    return;
+  }
+
+  auto pool = buffer->pool;
+  qos_core_migrator migrator(pool->core);
+  if (qos_atomic_add(&buffer->cores_remaining, -1) == 0) {
+    qos_write_queue(&pool->free, &data, sizeof(data), QOS_NO_BLOCKING);
+  }
+}
+
+//////// Topic ////////
+
+qos_bus_topic_t* QOS_INITIALIZATION qos_new_bus_topic() {
+  auto topic = new qos_bus_topic_t;
+  qos_init_bus_topic(topic);
+  return topic;
+}
+
+void QOS_INITIALIZATION qos_init_bus_topic(qos_bus_topic_t* topic) {
+  topic->subscribers = nullptr;
+}
+
+int32_t qos_publish_bus(qos_bus_topic_t* topic, void* data) {
+  auto buffer = get_buffer(data);
+
+  // Before any subscriber can observe the buffer, replace the publisher's reference with one for each subscriber.
+  int32_t refs[NUM_CORES] = {};
+  for (auto subscriber = topic->subscribers; subscriber; subscriber = subscriber->next) {
+    ++refs[subscriber->core];
+  }
+
+  int32_t cores_remaining = 0;
+  for (auto core = 0; core < NUM_CORES; ++core) {
+    buffer->refs[core] = refs[core];
+    cores_remaining += refs[core] != 0;
+  }
+
+  if (cores_remaining == 0) {
+    qos_core_migrator migrator(buffer->pool->core);
+    qos_write_queue(&buffer->pool->free, &data, sizeof(data), QOS_NO_BLOCKING);
+    return 0;
+  }
+
+  buffer->cores_remaining = cores_remaining;
+  __dmb();
+
+  // Deliver to subscribers on the current core first, then migrate at most once per other core.
+  int32_t delivered = 0;
+  auto core = get_core_num();
+  for (auto i = 0; i < NUM_CORES; ++i, core = (core + 1) % NUM_CORES) {
+    if (refs[core] == 0) {
+      continue;
+    }
+
+    qos_core_migrator migrator(core);
+    for (auto subscriber = topic->subscribers; subscriber; subscriber = subscriber->next) {
+      if (subscriber->core != core) {
+        continue;
+      }
+
+      if (qos_write_queue(&subscriber->received, &data, sizeof(data), QOS_NO_BLOCKING)) {
+        ++delivered;
+      } else {
+        qos_release_bus_buffer(data);
+      }
+    }
+  }
+
+  return delivered;
+}
+
+//////// Subscriber ////////
+
+qos_bus_subscriber_t* QOS_INITIALIZATION qos_new_bus_subscriber(qos_bus_topic_t* topic, int32_t capacity) {
+  auto subscriber = new qos_bus_subscriber_t;
+  qos_init_bus_subscriber(subscriber, topic, new void*[capacity], capacity);
+  return subscriber;
+}
+
+void QOS_INITIALIZATION qos_init_bus_subscriber(qos_bus_subscriber_t* subscriber, qos_bus_topic_t* topic,
+                                                void* buffer, int32_t capacity) {
+  subscriber->core = get_core_num();
+  qos_init_queue(&subscriber->received, buffer, capacity * sizeof(void*));
+
+  subscriber->next = topic->subscribers;
+  topic->subscribers = subscriber;
+}
+
+void* qos_receive_bus(qos_bus_subscriber_t* subscriber, qos_time_t timeout) {
+  assert(subscriber->core == get_core_num());
+
+  void* data;
+  if (!qos_read_queue(&subscriber->received, &data, sizeof(data), timeout)) {
+    return nullptr;
+  }
+  return data;
+}
@@ -0,0 +1,44 @@
+#ifndef QOS_BUS_H
+#define QOS_BUS_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+// Size in bytes of the buffer needed by a pool of count buffers, each of buffer_size bytes.
+#define QOS_BUS_POOL_BUFFER_SIZE(count, buffer_size) ((count) * (4 + 16 + (((buffer_size) + 7) & ~7)))
+
+// Fixed pool of reference counted buffers.
+struct qos_bus_pool_t* qos_new_bus_pool(int32_t count, int32_t buffer_size);
+void qos_init_bus_pool(struct qos_bus_pool_t* pool, void* buffer, int32_t count, int32_t buffer_size);
+
+// Returns a buffer from the pool, or null on timeout. The caller holds the only reference.
+void* qos_acquire_bus_buffer(struct qos_bus_pool_t* pool, qos_time_t timeout);
+
+// Releases the calling task's reference to a buffer. The buffer returns to its pool once every
+// reference has been released. References are counted per core, so this must be called on the core
+// on which the reference was acquired or received; a task that has since migrated must migrate back.
+void qos_release_bus_buffer(void* data);
+
+// Publish / subscribe topic. All subscribers must be initialized before the first publish.
+struct qos_bus_topic_t* qos_new_bus_topic();
+void qos_init_bus_topic(struct qos_bus_topic_t* topic);
+
+// Transfers the publishing task's reference to a buffer to the topic's subscribers, without copying
+// the buffer. Subscribers whose queue of received buffers is full miss the buffer. Returns the number
+// of subscribers that received it.
+int32_t qos_publish_bus(struct qos_bus_topic_t* topic, void* data);
+
+// A subscriber has affinity to the core on which it was initialized and is received from by tasks on
+// that core. It queues up to capacity published buffers.
+struct qos_bus_subscriber_t* qos_new_bus_subscriber(struct qos_bus_topic_t* topic, int32_t capacity);
+void qos_init_bus_subscriber(struct qos_bus_subscriber_t* subscriber, struct qos_bus_topic_t* topic,
+                             void* buffer, int32_t capacity);
+
+// Returns the next published buffer, or null on timeout. The caller must release it on the
+// subscriber's core.
+void* qos_receive_bus(struct qos_bus_subscriber_t* subscriber, qos_time_t timeout);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_BUS_H
@@ -0,0 +1,37 @@
+#ifndef QOS_BUS_INTERNAL_H
+#define QOS_BUS_INTERNAL_H
+
+#include "bus.h"
+
+#include "queue.internal.h"
+
+QOS_BEGIN_EXTERN_C
+
+// Precedes the data of each buffer in the pool.
+typedef struct qos_bus_buffer_t {
+  struct qos_bus_pool_t* pool;
+
+  // Each core's count is only modified by tasks on that core. The core that decrements its count
+  // to zero then migrates to the pool's core to decrement cores_remaining.
+  qos_atomic32_t refs[NUM_CORES];
+  qos_atomic32_t cores_remaining;
+} qos_bus_buffer_t;
+
+typedef struct qos_bus_pool_t {
+  int8_t core;
+  qos_queue_t free;  // pointers to data of free buffers
+} qos_bus_pool_t;
+
+typedef struct qos_bus_subscriber_t {
+  struct qos_bus_subscriber_t* next;
+  int8_t core;
+  qos_queue_t received;  // pointers to data of received buffers
+} qos_bus_subscriber_t;
+
+typedef struct qos_bus_topic_t {
+  qos_bus_subscriber_t* subscribers;
+} qos_bus_topic_t;
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_BUS_INTERNAL_H
@@ -1,18 +1,38 @@
 // The purpose of this file is to ensure that no C++ slips into public header files.
 
 #include "atomic.h"
+#include "batch.h"
+#include "bus.h"
+#include "bus.internal.h"
 #include "divide.h"
 #include "dlist.h"
+#include "dpc.h"
+#include "dpc.internal.h"
 #include "event.h"
+#include "heap.h"
 #include "interrupt.h"
 #include "io.h"
+#include "log.h"
+#include "message_queue.h"
+#include "message_queue.internal.h"
 #include "mutex.h"
 #include "mutex.internal.h"
+#include "notify.h"
+#include "notify.internal.h"
 #include "parallel.h"
+#include "placement.h"
+#include "pool.h"
+#include "pool.internal.h"
+#include "priority_queue.h"
+#include "priority_queue.internal.h"
 #include "queue.h"
 #include "queue.internal.h"
+#include "rpc.h"
+#include "rpc.internal.h"
 #include "semaphore.h"
 #include "semaphore.internal.h"
+#include "sharded_queue.h"
+#include "sharded_queue.internal.h"
 #include "spsc_queue.h"
 #include "spsc_queue.internal.h"
 #include "task.h"
@@ -17,14 +17,49 @@
 #endif
 #endif
 
+// Besides events created by the program, each sharded queue uses one event on every core and buffered stdio uses
+// five events per UART on the core that initializes it.
 #ifndef QOS_MAX_EVENTS_PER_CORE
 #define QOS_MAX_EVENTS_PER_CORE 8
 #endif
 
+// Capacity of each of a core's rings of deferred procedure calls, one per ISR priority. Must be a power of two.
+#ifndef QOS_DPC_RING_SIZE
+#define QOS_DPC_RING_SIZE 16
+#endif
+
+// Capacity in records of each of a core's log rings, one for tasks and one per exception priority. Must be a power
+// of two.
+#ifndef QOS_LOG_RING_SIZE
+#define QOS_LOG_RING_SIZE 16
+#endif
+
 #ifndef QOS_EXCEPTION_STACK_SIZE
 #define QOS_EXCEPTION_STACK_SIZE (PICO_STACK_SIZE - 256)
 #endif
 
+// Fill unused stack with a pattern at initialization so qos_get_stack_usage() can report each stack's high water
+// mark.
+#ifndef QOS_PAINT_STACKS
+#define QOS_PAINT_STACKS 1
+#endif
+
+// Headroom, as a percentage of high water mark, included in the stack size recommended by qos_get_stack_usage().
+#ifndef QOS_STACK_MARGIN_PERCENT
+#define QOS_STACK_MARGIN_PERCENT 25
+#endif
+
+// Include in each TCB a pointer to optional interpolator context, allocated by qos_save_context(). If 0,
+// qos_save_context() is unavailable and context switches never check for interpolator context.
+#ifndef QOS_TASK_INTERP_CONTEXT
+#define QOS_TASK_INTERP_CONTEXT 1
+#endif
+
+// Include in each TCB the fields needed by qos_init_parallel() and qos_parallel().
+#ifndef QOS_TASK_PARALLEL
+#define QOS_TASK_PARALLEL 1
+#endif
+
 #ifndef QOS_SYSTICK_CHECKS_STACK_OVERFLOW
 #ifdef NDEBUG
 #define QOS_SYSTICK_CHECKS_STACK_OVERFLOW 0
@@ -47,6 +82,12 @@
 #define QOS_PROTECT_TASK_STACK 1
 #endif
 
+// Record in each supervisor the most SysTick cycles spent reprogramming the task stack guard on a context switch.
+// Only meaningful with QOS_TICK_1MHZ_SOURCE 0, so SysTick counts processor cycles.
+#ifndef QOS_MEASURE_STACK_GUARD_CYCLES
+#define QOS_MEASURE_STACK_GUARD_CYCLES 0
+#endif
+
 // Hard fault if guard region at end of exception stack is accessed.
 #ifndef QOS_PROTECT_EXCEPTION_STACK
 #define QOS_PROTECT_EXCEPTION_STACK 1
@@ -67,6 +108,17 @@
 #define QOS_PROTECT_CORE1_SCRATCH_BANK 1
 #endif
 
+// Where qos_new_task() places each task's TCB and stack. See qos_placement_t. Tasks migrate, so QOS_PLACE_LOCAL
+// only uses a scratch bank the other core may access; while both are protected, it would always fall back to
+// striped SRAM, which is then the default.
+#ifndef QOS_DEFAULT_TASK_PLACEMENT
+#if QOS_PROTECT_CORE0_SCRATCH_BANK && QOS_PROTECT_CORE1_SCRATCH_BANK
+#define QOS_DEFAULT_TASK_PLACEMENT QOS_PLACE_STRIPED
+#else
+#define QOS_DEFAULT_TASK_PLACEMENT QOS_PLACE_LOCAL
+#endif
+#endif
+
 // Support for hard fault if core 0 attempts to access flash RAM. Must also be
 // enabled at runtime with qos_protect_flash().
 #ifndef QOS_PROTECT_CORE0_FLASH
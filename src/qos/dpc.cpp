@@ -0,0 +1,126 @@
+#include "dpc.h"
+#include "dpc.internal.h"
+
+#include "interrupt.h"
+#include "svc.h"
+#include "task.h"
+
+#include "hardware/regs/m0plus.h"
+#include "hardware/structs/scb.h"
+#include "hardware/sync.h"
+
+static_assert((QOS_DPC_RING_SIZE & (QOS_DPC_RING_SIZE - 1)) == 0, "QOS_DPC_RING_SIZE must be a power of two");
+
+struct dpc_t {
+  qos_dpc_proc_t proc;
+  void* arg;
+};
+
+// ISRs of the same priority never preempt one another so each ring has a single producer: whichever
+// ISR of its priority is running. The consumer runs at lower priority than every producer so neither
+// ever needs to disable interrupts.
+struct dpc_ring_t {
+  qos_atomic32_t write_count;
+  qos_atomic32_t read_count;
+  dpc_t dpcs[QOS_DPC_RING_SIZE];
+};
+
+static dpc_ring_t g_dpc_rings[NUM_CORES][QOS_NUM_EXCEPTION_PRIORITIES];
+static volatile bool g_dpc_posted[NUM_CORES];
+
+static qos_task_t* g_dpc_tasks[NUM_CORES];
+static volatile bool g_dpc_task_awaiting[NUM_CORES];
+
+bool QOS_HANDLER_MODE qos_post_dpc_from_isr(qos_dpc_proc_t proc, void* arg) {
+  auto core = get_core_num();
+  auto& ring = g_dpc_rings[core][qos_get_exception_priority()];
+
+  auto write_count = ring.write_count;
+  if (write_count - ring.read_count == QOS_DPC_RING_SIZE) {
+    return false;
+  }
+
+  auto& dpc = ring.dpcs[write_count & (QOS_DPC_RING_SIZE - 1)];
+  dpc.proc = proc;
+  dpc.arg = arg;
+
+  __dmb();
+  ring.write_count = write_count + 1;
+
+  g_dpc_posted[core] = true;
+  scb_hw->icsr = M0PLUS_ICSR_PENDSVSET_BITS;
+  return true;
+}
+
+static void QOS_TIME_CRITICAL run_posted_dpcs(int32_t core) {
+  // Lower numbers are higher priority.
+  for (auto priority = 0; priority < QOS_NUM_EXCEPTION_PRIORITIES; ++priority) {
+    auto& ring = g_dpc_rings[core][priority];
+    auto read_count = ring.read_count;
+    while (read_count != ring.write_count) {
+      __dmb();
+      auto dpc = ring.dpcs[read_count & (QOS_DPC_RING_SIZE - 1)];
+      ring.read_count = ++read_count;
+
+      dpc.proc(dpc.arg);
+    }
+  }
+}
+
+static bool QOS_HANDLER_MODE any_posted_dpcs(int32_t core) {
+  for (auto priority = 0; priority < QOS_NUM_EXCEPTION_PRIORITIES; ++priority) {
+    auto& ring = g_dpc_rings[core][priority];
+    if (ring.read_count != ring.write_count) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void QOS_HANDLER_MODE qos_internal_handle_posted_dpcs_supervisor(qos_supervisor_t* supervisor, qos_task_state_t* task_state) {
+  auto core = supervisor->core;
+  if (!g_dpc_posted[core]) {
+    return;
+  }
+  g_dpc_posted[core] = false;
+
+  auto task = g_dpc_tasks[core];
+  if (!task) {
+    run_posted_dpcs(core);
+    return;
+  }
+
+  if (g_dpc_task_awaiting[core]) {
+    g_dpc_task_awaiting[core] = false;
+    qos_ready_task(supervisor, task_state, task);
+  }
+}
+
+static qos_task_state_t QOS_HANDLER_MODE await_dpc_supervisor(qos_supervisor_t* supervisor, void*) {
+  auto core = supervisor->core;
+
+  // An ISR posting after this test pends PendSV, which cannot run until this supervisor call returns.
+  if (any_posted_dpcs(core)) {
+    return QOS_TASK_RUNNING;
+  }
+
+  g_dpc_task_awaiting[core] = true;
+  return QOS_TASK_SYNC_BLOCKED;
+}
+
+static void run_dpc_task() {
+  auto core = get_core_num();
+  for (;;) {
+    run_posted_dpcs(core);
+    qos_call_supervisor(await_dpc_supervisor, nullptr);
+  }
+}
+
+qos_task_t* QOS_INITIALIZATION qos_new_dpc_task(uint8_t priority, int32_t stack_size) {
+  auto core = get_core_num();
+  assert(!g_dpc_tasks[core]);
+
+  auto task = qos_new_task(priority, run_dpc_task, stack_size);
+  g_dpc_tasks[core] = task;
+  return task;
+}
@@ -0,0 +1,24 @@
+#ifndef QOS_DPC_H
+#define QOS_DPC_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+typedef void (*qos_dpc_proc_t)(void* arg);
+
+// Deferred procedure calls posted by an ISR run later, on the same core, in the order they were
+// posted by ISRs of the same priority and ahead of those posted by lower priority ISRs.
+//
+// If a DPC task was created on the core, DPCs run in that task at its priority. Otherwise they
+// run in PendSV after signalled events are handled, ahead of all tasks, where, like ISRs, they
+// may only call _from_isr functions.
+struct qos_task_t* qos_new_dpc_task(uint8_t priority, int32_t stack_size);
+
+// Returns false if the core's DPC ring for this ISR's priority is full. Unlike most _from_isr
+// functions, need not be preceded by qos_roll_back_atomic_from_isr().
+bool qos_post_dpc_from_isr(qos_dpc_proc_t proc, void* arg);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_DPC_H
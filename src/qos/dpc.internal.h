@@ -0,0 +1,13 @@
+#ifndef QOS_DPC_INTERNAL_H
+#define QOS_DPC_INTERNAL_H
+
+#include "dpc.h"
+#include "task.internal.h"
+
+QOS_BEGIN_EXTERN_C
+
+void qos_internal_handle_posted_dpcs_supervisor(qos_supervisor_t* supervisor, qos_task_state_t* task_state);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_DPC_INTERNAL_H
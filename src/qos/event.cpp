@@ -3,28 +3,45 @@
 
 #include "atomic.h"
 #include "core_migrator.h"
+#include "interrupt.h"
 #include "svc.h"
 #include "time.h"
 
+#include "hardware/regs/sio.h"
 #include "hardware/structs/scb.h"
+#include "hardware/structs/sio.h"
 
 static volatile bool g_signalled[NUM_CORES][QOS_MAX_EVENTS_PER_CORE];
 static qos_event_t* g_events[NUM_CORES][QOS_MAX_EVENTS_PER_CORE];
 static int8_t g_next_idx[NUM_CORES];
 
+// Set by an ISR that signalled an event of the other core. The supervisor of the ISR's core then asks
+// the other core to check all its events.
+static volatile bool g_forward_signalled[NUM_CORES];
+
 static void QOS_HANDLER_MODE signal_event_handler(qos_supervisor_t* supervisor, qos_task_state_t* task_state, intptr_t handler);
 
 qos_event_t* QOS_INITIALIZATION qos_new_event(int32_t core) {
+  return qos_new_event_with_mode(core, QOS_EVENT_AUTO_RESET_ONE);
+}
+
+void QOS_INITIALIZATION qos_init_event(qos_event_t* event, int32_t core) {
+  qos_init_event_with_mode(event, core, QOS_EVENT_AUTO_RESET_ONE);
+}
+
+qos_event_t* QOS_INITIALIZATION qos_new_event_with_mode(int32_t core, qos_event_mode_t mode) {
   auto event = new qos_event_t;
-  qos_init_event(event, core);
+  qos_init_event_with_mode(event, core, mode);
   return event;
 }
 
-void QOS_INITIALIZATION qos_init_event(qos_event_t* event, int32_t core) {
+void QOS_INITIALIZATION qos_init_event_with_mode(qos_event_t* event, int32_t core, qos_event_mode_t mode) {
   if (core < 0) {
     core = get_core_num();
   }
   event->core = core;
+  event->mode = mode;
+  event->awaited = false;
 
   qos_init_dlist(&event->waiting.tasks);
 
@@ -36,17 +53,16 @@ void QOS_INITIALIZATION qos_init_event(qos_event_t* event, int32_t core) {
   g_events[core][idx] = event;
 }
 
-static qos_task_state_t QOS_HANDLER_MODE await_event_supervisor(qos_supervisor_t* supervisor, va_list args) {
-  auto event = va_arg(args, qos_event_t*);
-  auto timeout = va_arg(args, qos_time_t);
-
+qos_task_state_t QOS_HANDLER_MODE qos_internal_await_event_supervisor(qos_event_t* event, qos_time_t timeout) {
   assert(timeout != 0);
-  assert(qos_is_dlist_empty(&event->waiting.tasks));
 
+  auto supervisor = qos_internal_get_supervisor();
   auto current_task = supervisor->current_task;
 
   if (*event->signalled) {
-    *event->signalled = false;
+    if (event->mode != QOS_EVENT_MANUAL_RESET) {
+      *event->signalled = false;
+    }
     qos_current_supervisor_call_result(supervisor, true);
     return QOS_TASK_RUNNING;
   }
@@ -63,7 +79,9 @@ bool qos_await_event(qos_event_t* event, qos_time_t timeout) {
   qos_core_migrator migrator(event->core);
 
   if (*event->signalled) {
-    *event->signalled = false;
+    if (event->mode != QOS_EVENT_MANUAL_RESET) {
+      *event->signalled = false;
+    }
     return true;
   }
 
@@ -71,7 +89,7 @@ bool qos_await_event(qos_event_t* event, qos_time_t timeout) {
     return false;
   }
 
-  return qos_call_supervisor_va(await_event_supervisor, event, timeout);
+  return qos_call_supervisor_regs(qos_internal_await_event_supervisor, event, timeout);
 }
 
 static void QOS_HANDLER_MODE handle_signalled_supervisor(qos_supervisor_t* supervisor, qos_task_state_t* task_state, qos_event_t* event) {
@@ -83,16 +101,57 @@ static void QOS_HANDLER_MODE handle_signalled_supervisor(qos_supervisor_t* super
   }
 
   // Can be true here if signalled from ISR or other core.
-  *event->signalled = false;
+  if (event->mode != QOS_EVENT_MANUAL_RESET) {
+    *event->signalled = false;
+  }
 
-  auto task = &*waiting;
-  qos_supervisor_call_result(supervisor, task, true);
-  qos_ready_task(supervisor, task_state, task);
+  // All waiting tasks are readied in this one pass, except in auto-reset-one mode,
+  // where only the highest priority waiting task is readied.
+  do {
+    auto task = &*begin(event->waiting);
+    qos_supervisor_call_result(supervisor, task, true);
+    qos_ready_task(supervisor, task_state, task);
+  } while (event->mode != QOS_EVENT_AUTO_RESET_ONE && !empty(begin(event->waiting)));
+}
+
+static void QOS_HANDLER_MODE handle_all_signalled_handler(qos_supervisor_t* supervisor, qos_task_state_t* task_state, intptr_t) {
+  qos_internal_handle_signalled_events_supervisor(supervisor, task_state);
+}
+
+static qos_fifo_handler_t g_handle_all_signalled_handler = handle_all_signalled_handler;
+
+// Never waits for the FIFO to become ready. Only called by the supervisor, which ISRs never preempt to write the
+// FIFO. Tasks do write it, with qos_internal_atomic_write_fifo(), and this might run in PendSV, SysTick or the FIFO
+// IRQ without a context switch, so the preempted task is rolled back first. Otherwise, it might have tested that
+// the FIFO is ready before this fills the last slot, and then its write would overflow.
+static bool QOS_HANDLER_MODE try_write_fifo(qos_fifo_handler_t* handler) {
+  qos_roll_back_atomic_from_isr();
+
+  if ((sio_hw->fifo_st & SIO_FIFO_ST_RDY_BITS) == 0) {
+    return false;
+  }
+
+  sio_hw->fifo_wr = (int32_t) handler;
+  __sev();
+  return true;
+}
+
+void QOS_HANDLER_MODE qos_internal_forward_signalled_events_supervisor() {
+  auto core = get_core_num();
+  if (g_forward_signalled[core]) {
+    g_forward_signalled[core] = false;
+    if (!try_write_fifo(&g_handle_all_signalled_handler)) {
+      // Try again on next PendSV or SysTick.
+      g_forward_signalled[core] = true;
+    }
+  }
 }
 
 void QOS_HANDLER_MODE qos_internal_handle_signalled_events_supervisor(qos_supervisor_t* supervisor, qos_task_state_t* task_state) {
   auto core = get_core_num();
 
+  qos_internal_forward_signalled_events_supervisor();
+
   for (auto i = 0; i < QOS_MAX_EVENTS_PER_CORE; ++i) {
     if (g_signalled[core][i]) {
       handle_signalled_supervisor(supervisor, task_state, g_events[core][i]);
@@ -115,6 +174,10 @@ qos_task_state_t QOS_HANDLER_MODE signal_event_supervisor(qos_supervisor_t* supe
   return task_state;
 }
 
+qos_task_state_t QOS_HANDLER_MODE qos_internal_signal_event_supervisor(qos_event_t* event) {
+  return signal_event_supervisor(qos_internal_get_supervisor(), event);
+}
+
 void qos_signal_event(qos_event_t* event) {
   if (event->core == get_core_num()) {
     qos_call_supervisor(signal_event_supervisor, event);
@@ -125,7 +188,19 @@ void qos_signal_event(qos_event_t* event) {
 }
 
 void QOS_HANDLER_MODE qos_signal_event_from_isr(qos_event_t* event) {
-  assert(event->core == get_core_num());
   *event->signalled = true;
+
+  // ISRs never write the FIFO; they might preempt the supervisor between it testing that the FIFO is
+  // ready and writing to it.
+  auto core = get_core_num();
+  if (event->core != core) {
+    __dmb();
+    g_forward_signalled[core] = true;
+  }
+
   scb_hw->icsr = M0PLUS_ICSR_PENDSVSET_BITS;
 }
+
+void qos_reset_event(qos_event_t* event) {
+  *event->signalled = false;
+}
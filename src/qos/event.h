@@ -5,12 +5,24 @@
 
 QOS_BEGIN_EXTERN_C
 
+typedef enum qos_event_mode_t {
+  QOS_EVENT_AUTO_RESET_ONE,   // signal readies highest priority waiting task then resets
+  QOS_EVENT_AUTO_RESET_ALL,   // signal readies all waiting tasks then resets
+  QOS_EVENT_MANUAL_RESET,     // signal readies all waiting tasks; stays signalled until qos_reset_event()
+} qos_event_mode_t;
+
 struct qos_event_t* qos_new_event(int32_t core);
 void qos_init_event(struct qos_event_t* event, int32_t core);
+struct qos_event_t* qos_new_event_with_mode(int32_t core, qos_event_mode_t mode);
+void qos_init_event_with_mode(struct qos_event_t* event, int32_t core, qos_event_mode_t mode);
 bool qos_await_event(struct qos_event_t* event, qos_time_t timeout);
 void qos_signal_event(struct qos_event_t* event);
+
+// May signal an event with affinity to either core.
 void qos_signal_event_from_isr(struct qos_event_t* event);
 
+void qos_reset_event(struct qos_event_t* event);
+
 QOS_END_EXTERN_C
 
 #endif  // QOS_EVENT_H
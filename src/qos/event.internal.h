@@ -4,18 +4,54 @@
 #include "event.h"
 #include "task.internal.h"
 
+#include "hardware/sync.h"
+
 QOS_BEGIN_EXTERN_C
 
 typedef struct qos_event_t {
   int8_t core;
+  int8_t mode;
   volatile bool* signalled;
-  qos_task_scheduling_dlist_t waiting;  // contains zero or one tasks only
+  qos_task_scheduling_dlist_t waiting;
+
+  // Set by a task, possibly on another core, that intends to await the event. See
+  // qos_internal_set_event_awaited().
+  volatile bool awaited;
 
   // FIFO handlers
   qos_fifo_handler_t signal_handler;
 } qos_event_t;
 
 void qos_internal_handle_signalled_events_supervisor(qos_supervisor_t* supervisor, qos_task_state_t* task_state);
+void qos_internal_forward_signalled_events_supervisor();
+
+// Typed supervisor procs, also run as steps of compound supervisor calls. The event must have affinity to the
+// supervisor's core.
+qos_task_state_t qos_internal_await_event_supervisor(qos_event_t* event, qos_time_t timeout);
+qos_task_state_t qos_internal_signal_event_supervisor(qos_event_t* event);
+
+// For synchronization objects where a single task awaits the event until some condition holds. The
+// task sets awaited before rechecking the condition and clears it once the condition holds. Signallers
+// make the condition hold before testing awaited, so at least one of the two observes the other and
+// signalling can safely be skipped when nothing awaits the event.
+static inline void qos_internal_set_event_awaited(qos_event_t* event, bool awaited) {
+  event->awaited = awaited;
+  __dmb();
+}
+
+static inline void qos_internal_signal_awaited_event(qos_event_t* event) {
+  __dmb();
+  if (event->awaited) {
+    qos_signal_event(event);
+  }
+}
+
+static inline void qos_internal_signal_awaited_event_from_isr(qos_event_t* event) {
+  __dmb();
+  if (event->awaited) {
+    qos_signal_event_from_isr(event);
+  }
+}
 
 QOS_END_EXTERN_C
 
@@ -0,0 +1,150 @@
+#include "heap.h"
+
+#include "pool.h"
+#include "pool.internal.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "pico/mutex.h"
+
+// Precedes every block, keeping blocks 8 byte aligned.
+struct header_t {
+  qos_pool_t* pool;  // null if allocated from the C library heap
+  int32_t size;      // usable bytes
+};
+
+static_assert(sizeof(header_t) == 8);
+static_assert(QOS_HEAP_ARENA_BUFFER_SIZE(1, 1, 1, 1, 1, 1) == (16 << QOS_HEAP_NUM_CLASSES) - 16);
+
+struct arena_t {
+  qos_pool_t* pools[QOS_HEAP_NUM_CLASSES];  // null for size classes with no blocks
+  qos_pool_t pool_storage[QOS_HEAP_NUM_CLASSES];
+};
+
+static arena_t g_arenas[NUM_CORES];
+
+auto_init_mutex(g_fallback_mutex);
+
+static int32_t get_class_size(int32_t size_class) {
+  return 16 << size_class;
+}
+
+static int32_t get_size_class(size_t total_size) {
+  int32_t size_class = 0;
+  while (size_class < QOS_HEAP_NUM_CLASSES && size_t(get_class_size(size_class)) < total_size) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+void QOS_INITIALIZATION qos_new_heap_arena(const int32_t counts[QOS_HEAP_NUM_CLASSES]) {
+  auto buffer = new int64_t[QOS_HEAP_ARENA_BUFFER_SIZE(counts[0], counts[1], counts[2], counts[3], counts[4], counts[5]) / sizeof(int64_t)];
+  qos_init_heap_arena(counts, buffer);
+}
+
+// The buffer may be placed in the calling core's scratch bank, e.g. with __scratch_x() or __scratch_y(), provided
+// QOS_PROTECT_COREx_SCRATCH_BANK does not prevent the other core from accessing blocks it frees or is passed.
+void QOS_INITIALIZATION qos_init_heap_arena(const int32_t counts[QOS_HEAP_NUM_CLASSES], void* buffer) {
+  assert((uintptr_t(buffer) & 7) == 0);
+
+  auto& arena = g_arenas[get_core_num()];
+  auto p = (char*) buffer;
+  for (auto i = 0; i < QOS_HEAP_NUM_CLASSES; ++i) {
+    assert(counts[i] >= 0);
+    if (counts[i] == 0) {
+      continue;
+    }
+
+    auto pool = &arena.pool_storage[i];
+    qos_init_pool(pool, p, counts[i], get_class_size(i), false);
+    p += QOS_POOL_BUFFER_SIZE(counts[i], get_class_size(i));
+    arena.pools[i] = pool;
+  }
+}
+
+void* qos_malloc(size_t size) {
+  if (size > SIZE_MAX - sizeof(header_t)) {
+    return nullptr;
+  }
+
+  auto total_size = size + sizeof(header_t);
+
+  // Fall back to the next larger size class if the arena has no free block of the best size class.
+  auto& arena = g_arenas[get_core_num()];
+  for (auto i = get_size_class(total_size); i < QOS_HEAP_NUM_CLASSES; ++i) {
+    auto pool = arena.pools[i];
+    if (!pool) {
+      continue;
+    }
+
+    auto header = (header_t*) qos_allocate_pool_block(pool, 0);
+    if (header) {
+      header->pool = pool;
+      header->size = get_class_size(i) - sizeof(header_t);
+      return header + 1;
+    }
+  }
+
+  mutex_enter_blocking(&g_fallback_mutex);
+  auto header = (header_t*) malloc(total_size);
+  mutex_exit(&g_fallback_mutex);
+
+  if (!header) {
+    return nullptr;
+  }
+
+  header->pool = nullptr;
+  header->size = size;
+  return header + 1;
+}
+
+void* qos_calloc(size_t count, size_t size) {
+  auto total_size = count * size;
+  if (size && total_size / size != count) {
+    return nullptr;
+  }
+
+  auto p = qos_malloc(total_size);
+  if (p) {
+    memset(p, 0, total_size);
+  }
+  return p;
+}
+
+void* qos_realloc(void* p, size_t size) {
+  if (!p) {
+    return qos_malloc(size);
+  }
+
+  auto header = ((header_t*) p) - 1;
+  if (size <= size_t(header->size)) {
+    return p;
+  }
+
+  auto new_p = qos_malloc(size);
+  if (new_p) {
+    memcpy(new_p, p, header->size);
+    qos_free(p);
+  }
+  return new_p;
+}
+
+// Blocks freed on other than the allocating core go on the pool's remote free list.
+void qos_free(void* p) {
+  if (!p) {
+    return;
+  }
+
+  auto header = ((header_t*) p) - 1;
+  if (header->pool) {
+    qos_free_pool_block(header->pool, header);
+    return;
+  }
+
+  mutex_enter_blocking(&g_fallback_mutex);
+  free(header);
+  mutex_exit(&g_fallback_mutex);
+}
@@ -0,0 +1,32 @@
+#ifndef QOS_HEAP_H
+#define QOS_HEAP_H
+
+#include "base.h"
+
+#include <stddef.h>
+
+QOS_BEGIN_EXTERN_C
+
+// Blocks of size class i are 16 << i bytes, including an 8 byte header.
+#define QOS_HEAP_NUM_CLASSES 6
+
+// Size in bytes of the buffer needed by an arena with the given number of blocks of each size class.
+#define QOS_HEAP_ARENA_BUFFER_SIZE(n16, n32, n64, n128, n256, n512) \
+  ((n16) * 16 + (n32) * 32 + (n64) * 64 + (n128) * 128 + (n256) * 256 + (n512) * 512)
+
+// Gives the calling core a heap arena with counts[i] blocks of size class i. Must be called on each core that is to
+// have an arena, before starting the RTOS.
+void qos_new_heap_arena(const int32_t counts[QOS_HEAP_NUM_CLASSES]);
+void qos_init_heap_arena(const int32_t counts[QOS_HEAP_NUM_CLASSES], void* buffer);
+
+// Allocation from the calling core's arena never migrates or blocks. Requests too large for any size class, or
+// for which the arena has no free block, fall back to the C library heap, serialized by a mutex. May be called
+// from tasks on either core; a block may be freed on either core.
+void* qos_malloc(size_t size);
+void* qos_calloc(size_t count, size_t size);
+void* qos_realloc(void* p, size_t size);
+void qos_free(void* p);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_HEAP_H
@@ -18,11 +18,48 @@ extern "C" {
   void qos_supervisor_await_irq(qos_supervisor_t* supervisor);
 }
 
+struct irq_task_t {
+  qos_task_t task;
+  int32_t irq;
+  qos_irq_handler_t handler;
+  io_rw_32* enable;
+  int32_t mask;
+  bool awaiting;
+};
+
+static irq_task_t* g_irq_tasks[NUM_CORES][QOS_MAX_IRQS];
+
+static void QOS_HANDLER_MODE handle_threaded_irq(qos_supervisor_t* supervisor, irq_task_t* irq_task) {
+  // Mask the source until the task has run the handler. There is only one task to wake.
+  hw_clear_bits(irq_task->enable, irq_task->mask);
+  __dsb();
+
+  // The NVIC may have latched the IRQ again before the source was masked, in which case the task was already woken.
+  if (!irq_task->awaiting) {
+    return;
+  }
+  irq_task->awaiting = false;
+
+  auto task_state = QOS_TASK_RUNNING;
+  qos_ready_task(supervisor, &task_state, &irq_task->task);
+
+  if (task_state != QOS_TASK_RUNNING) {
+    supervisor->pendsv_task_state = task_state;
+    scb_hw->icsr = M0PLUS_ICSR_PENDSVSET_BITS;
+  }
+}
+
 void QOS_HANDLER_MODE qos_supervisor_await_irq(qos_supervisor_t* supervisor) {
   int32_t ipsr;
   __asm__ volatile ("mrs %0, ipsr" : "=r"(ipsr));
   auto irq = (ipsr & 0x3F) - 16;
 
+  auto irq_task = g_irq_tasks[supervisor->core][irq];
+  if (irq_task) {
+    handle_threaded_irq(supervisor, irq_task);
+    return;
+  }
+
   auto& tasks = supervisor->awaiting_irq[irq];
   
   // Atomically disable IRQ but leave it pending.
@@ -58,11 +95,18 @@ static void QOS_HANDLER_MODE unblock_await_irq(qos_task_t* task) {
   }
 }
 
-qos_task_state_t QOS_HANDLER_MODE qos_await_irq_supervisor(qos_supervisor_t* supervisor, va_list args) {
-  auto irq = va_arg(args, int32_t);
-  auto enable = va_arg(args, io_rw_32*);
-  auto mask = va_arg(args, int32_t);
-  auto timeout = va_arg(args, qos_time_t);
+// IRQ, enable and mask don't fit in registers alongside the timeout so are passed in a struct on the caller's stack.
+struct await_irq_call_t {
+  int32_t irq;
+  io_rw_32* enable;
+  int32_t mask;
+};
+
+static qos_task_state_t QOS_HANDLER_MODE await_irq_supervisor(const await_irq_call_t* call, qos_time_t timeout) {
+  auto irq = call->irq;
+  auto enable = call->enable;
+  auto mask = call->mask;
+  auto supervisor = qos_internal_get_supervisor();
   auto current_task = supervisor->current_task;
 
   auto& awaiting_irq = supervisor->awaiting_irq;
@@ -111,5 +155,68 @@ bool qos_await_irq(int32_t irq, io_rw_32* enable, int32_t mask, qos_time_t timeo
   qos_normalize_time(&timeout);
   assert(timeout != 0);
 
-  return qos_call_supervisor_va(qos_await_irq_supervisor, irq, enable, mask, timeout);
+  await_irq_call_t call = { irq, enable, mask };
+  return qos_call_supervisor_regs(await_irq_supervisor, &call, timeout);
+}
+
+static qos_task_state_t QOS_HANDLER_MODE await_threaded_irq_supervisor(qos_supervisor_t* supervisor, void* p) {
+  auto irq_task = (irq_task_t*) p;
+
+  // Unmask the source. If this raises the IRQ, the ISR cannot run until this supervisor call
+  // exits, by which time the task is awaiting.
+  hw_set_bits(irq_task->enable, irq_task->mask);
+  __dsb();
+
+  irq_task->awaiting = true;
+  return QOS_TASK_SYNC_BLOCKED;
+}
+
+static void run_irq_task() {
+  auto irq_task = (irq_task_t*) qos_current_task();
+  for (;;) {
+    qos_call_supervisor(await_threaded_irq_supervisor, irq_task);
+    irq_task->handler(irq_task->irq);
+  }
+}
+
+qos_task_t* QOS_INITIALIZATION qos_new_irq_task(int32_t irq, uint8_t priority, qos_irq_handler_t handler,
+                                                io_rw_32* enable, int32_t mask, int32_t stack_size) {
+  assert(irq >= 0 && irq < QOS_MAX_IRQS);
+  assert(enable && mask);
+
+  auto core = get_core_num();
+  assert(!g_irq_tasks[core][irq]);
+
+  auto irq_task = new irq_task_t;
+  irq_task->irq = irq;
+  irq_task->handler = handler;
+  irq_task->enable = enable;
+  irq_task->mask = mask;
+  irq_task->awaiting = false;
+
+  // The source remains masked until the task first awaits.
+  hw_clear_bits(enable, mask);
+  qos_init_task(&irq_task->task, priority, run_irq_task, new int32_t[(stack_size + 3) / 4], stack_size);
+
+  g_irq_tasks[core][irq] = irq_task;
+
+  qos_init_await_irq(irq);
+  irq_set_enabled(irq, true);
+
+  return &irq_task->task;
+}
+
+int32_t QOS_HANDLER_MODE qos_get_exception_priority() {
+  auto exception = qos_get_exception();
+  assert(exception > 0);
+
+  // SVCall, PendSV and SysTick have the lowest priority.
+  if (exception < 16) {
+    assert(exception >= 11);
+    return QOS_NUM_EXCEPTION_PRIORITIES - 1;
+  }
+
+  auto irq = exception - 16;
+  auto ipr = ((io_ro_32*) (PPB_BASE + M0PLUS_NVIC_IPR0_OFFSET))[irq >> 2];
+  return (ipr >> ((irq & 3) * 8 + 6)) & 3;
 }
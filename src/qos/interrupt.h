@@ -3,10 +3,15 @@
 
 #include "base.h"
 
+#define QOS_NUM_EXCEPTION_PRIORITIES 4
+
 QOS_BEGIN_EXTERN_C
 
 struct qos_event_t;
 struct qos_spsc_queue_t;
+struct qos_task_t;
+
+typedef void (*qos_irq_handler_t)(int32_t irq);
 
 static inline int32_t qos_get_exception() {
   int32_t r;
@@ -17,8 +22,19 @@ static inline int32_t qos_get_exception() {
 void qos_init_await_irq(int32_t irq);
 bool qos_await_irq(int32_t irq, io_rw_32* enable, int32_t mask, qos_time_t timeout);
 
+// Threaded IRQ. Creates a task on the current core that runs handler whenever the IRQ is raised. The ISR
+// masks the interrupt source by clearing mask bits in *enable and wakes the task; the task runs handler and
+// sets the bits again before awaiting the next IRQ. The handler therefore runs once per unmask, however many
+// times the source asserted meanwhile, so it should service all the conditions the source reports.
+struct qos_task_t* qos_new_irq_task(int32_t irq, uint8_t priority, qos_irq_handler_t handler,
+                                    io_rw_32* enable, int32_t mask, int32_t stack_size);
+
 void qos_roll_back_atomic_from_isr();
 
+// Returns the priority level of the current exception, from 0 (highest) to QOS_NUM_EXCEPTION_PRIORITIES - 1.
+// Exceptions of the same level never preempt one another.
+int32_t qos_get_exception_priority();
+
 QOS_END_EXTERN_C
 
 #endif  // QOS_INTERRUPT_H
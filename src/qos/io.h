@@ -9,6 +9,15 @@ QOS_BEGIN_EXTERN_C
 
 void qos_stdio_uart_init_full(uart_inst_t *uart, int32_t baud_rate, int32_t tx_pin, int32_t rx_pin);
 
+// Output is appended to a TX queue drained by the UART ISR, so callers only block when the queue is full. Input
+// is received by the ISR into an RX queue. The queues and flushing use five of the current core's events.
+void qos_stdio_uart_init_buffered(uart_inst_t *uart, int32_t baud_rate, int32_t tx_pin, int32_t rx_pin,
+                                  int32_t tx_capacity, int32_t rx_capacity);
+
+// Writes to a UART initialized by either of the above, bypassing stdio and its CR/LF translation. Serialized with
+// stdio output to the same UART, so neither splits the other, though they may interleave.
+void qos_stdio_uart_write_raw(uart_inst_t *uart, const void* data, int32_t size);
+
 QOS_END_EXTERN_C
 
 #endif  // QOS_STDIO_H
@@ -0,0 +1,163 @@
+#include "log.h"
+
+#include "atomic.h"
+#include "interrupt.h"
+#include "io.h"
+#include "task.h"
+#include "time.h"
+
+#include "hardware/structs/timer.h"
+#include "hardware/sync.h"
+
+#include <cstdarg>
+#include <cstring>
+
+static_assert((QOS_LOG_RING_SIZE & (QOS_LOG_RING_SIZE - 1)) == 0, "QOS_LOG_RING_SIZE must be a power of two");
+
+#define RINGS_PER_CORE (1 + QOS_NUM_EXCEPTION_PRIORITIES)
+#define FRAME_SYNC 0xA5
+
+struct log_record_t {
+  // Written last by the producer and cleared by the consumer, so null until the rest of the record is valid.
+  const char* volatile fmt;
+  uint32_t time;
+  int32_t num_args;
+  int32_t args[QOS_LOG_MAX_ARGS];
+};
+
+// Records are reserved in order by incrementing reserve_count, then filled in. A ring is only written on one
+// core. Ring 0 is written by tasks, which reserve records with atomic operations. Ring 1 + n is written by
+// exceptions of priority n, which never preempt one another.
+struct log_ring_t {
+  qos_atomic32_t reserve_count;
+  qos_atomic32_t read_count;
+  qos_atomic32_t dropped;
+  log_record_t records[QOS_LOG_RING_SIZE];
+};
+
+// Null until qos_new_log_task() is called, in which case log messages are discarded.
+static log_ring_t* volatile g_log_rings;
+static uart_inst_t* g_log_uart;
+
+void QOS_TIME_CRITICAL qos_log(const char* fmt, int32_t num_args, ...) {
+  auto rings = g_log_rings;
+  if (!rings) {
+    return;
+  }
+
+  assert(fmt);
+  assert(num_args >= 0 && num_args <= QOS_LOG_MAX_ARGS);
+
+  auto exception = qos_get_exception();
+  auto ring = &rings[get_core_num() * RINGS_PER_CORE + (exception ? 1 + qos_get_exception_priority() : 0)];
+
+  int32_t count;
+  if (exception) {
+    count = ring->reserve_count;
+    if (count - ring->read_count >= QOS_LOG_RING_SIZE) {
+      ++ring->dropped;
+      return;
+    }
+    ring->reserve_count = count + 1;
+  } else {
+    do {
+      count = ring->reserve_count;
+      if (count - ring->read_count >= QOS_LOG_RING_SIZE) {
+        qos_atomic_add(&ring->dropped, 1);
+        return;
+      }
+    } while (qos_atomic_compare_and_set(&ring->reserve_count, count, count + 1) != count);
+  }
+
+  auto& record = ring->records[count & (QOS_LOG_RING_SIZE - 1)];
+  record.time = timer_hw->timerawl;
+  record.num_args = num_args;
+
+  va_list args;
+  va_start(args, num_args);
+  for (auto i = 0; i < num_args; ++i) {
+    record.args[i] = va_arg(args, int32_t);
+  }
+  va_end(args);
+
+  __dmb();
+  record.fmt = fmt;
+}
+
+// Frame: sync byte, core << 4 | num_args, then time, format string address and arguments, each 32-bit little
+// endian. A null format string address reports the number of records dropped since the last report.
+static void write_frame(int32_t core, uint32_t time, const char* fmt, int32_t num_args, const int32_t* args) {
+  uint8_t frame[2 + 4 * (2 + QOS_LOG_MAX_ARGS)];
+  frame[0] = FRAME_SYNC;
+  frame[1] = (core << 4) | num_args;
+  memcpy(&frame[2], &time, 4);
+  memcpy(&frame[6], &fmt, 4);
+  memcpy(&frame[10], args, num_args * 4);
+
+  qos_stdio_uart_write_raw(g_log_uart, frame, 10 + num_args * 4);
+}
+
+static bool drain_ring(int32_t core, log_ring_t* ring, int32_t* reported_dropped) {
+  bool drained = false;
+
+  auto read_count = ring->read_count;
+  while (read_count != ring->reserve_count) {
+    auto& record = ring->records[read_count & (QOS_LOG_RING_SIZE - 1)];
+    auto fmt = record.fmt;
+    if (!fmt) {
+      // Reserved but not yet filled in.
+      break;
+    }
+
+    __dmb();
+    auto time = record.time;
+    auto num_args = record.num_args;
+    int32_t args[QOS_LOG_MAX_ARGS];
+    memcpy(args, record.args, sizeof(args));
+
+    record.fmt = nullptr;
+    __dmb();
+    ring->read_count = ++read_count;
+
+    write_frame(core, time, fmt, num_args, args);
+    drained = true;
+  }
+
+  int32_t dropped = ring->dropped;
+  if (dropped != *reported_dropped) {
+    int32_t count = dropped - *reported_dropped;
+    write_frame(core, timer_hw->timerawl, nullptr, 1, &count);
+    *reported_dropped = dropped;
+  }
+
+  return drained;
+}
+
+static void run_log_task() {
+  int32_t reported_dropped[NUM_CORES * RINGS_PER_CORE] = {};
+
+  for (;;) {
+    bool drained = false;
+    for (auto i = 0; i < NUM_CORES * RINGS_PER_CORE; ++i) {
+      drained |= drain_ring(i / RINGS_PER_CORE, &g_log_rings[i], &reported_dropped[i]);
+    }
+
+    // Logging never signals this task, which keeps it cheap, so poll.
+    if (!drained) {
+      qos_sleep(QOS_TIMEOUT_NEXT_TICK);
+    }
+  }
+}
+
+qos_task_t* QOS_INITIALIZATION qos_new_log_task(uint8_t priority, int32_t stack_size, uart_inst_t* uart) {
+  assert(!g_log_rings);
+
+  g_log_uart = uart;
+
+  auto rings = new log_ring_t[NUM_CORES * RINGS_PER_CORE];
+  memset(rings, 0, sizeof(log_ring_t) * NUM_CORES * RINGS_PER_CORE);
+  __dmb();
+  g_log_rings = rings;
+
+  return qos_new_task(priority, run_log_task, stack_size);
+}
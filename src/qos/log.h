@@ -0,0 +1,38 @@
+#ifndef QOS_LOG_H
+#define QOS_LOG_H
+
+#include "base.h"
+
+#include "hardware/uart.h"
+
+QOS_BEGIN_EXTERN_C
+
+#define QOS_LOG_MAX_ARGS 4
+
+// Records a log message without formatting it. fmt must be a string literal or otherwise stored in the ELF image;
+// only its address is recorded. Arguments must be 32-bit integers or pointers; %s arguments must also be stored in
+// the ELF image and floats must be wrapped in QOS_LOG_FLOAT(). May be called from tasks and ISRs.
+#define QOS_LOG(fmt, ...) qos_log(fmt, QOS_LOG_NUM_ARGS(__VA_ARGS__), ##__VA_ARGS__)
+
+#define QOS_LOG_FLOAT(x) qos_log_float_bits(x)
+
+#define QOS_LOG_NUM_ARGS(...) QOS_LOG_NUM_ARGS_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define QOS_LOG_NUM_ARGS_(_0, _1, _2, _3, _4, N, ...) N
+
+void qos_log(const char* fmt, int32_t num_args, ...);
+
+static inline int32_t qos_log_float_bits(float x) {
+  union { float f; int32_t i; } u;
+  u.f = x;
+  return u.i;
+}
+
+// Creates a task on the current core that streams log records from both cores to a UART, which must already
+// have been initialized with qos_stdio_uart_init_full() or qos_stdio_uart_init_buffered(). The records are
+// decoded on the host by tools/qos_log_decode.py. If the UART is also used by stdio, text appears between whole
+// frames; the decoder skips it when it searches for the next frame's sync byte.
+struct qos_task_t* qos_new_log_task(uint8_t priority, int32_t stack_size, uart_inst_t* uart);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_LOG_H
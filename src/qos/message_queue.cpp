@@ -0,0 +1,192 @@
+#include "message_queue.h"
+#include "message_queue.internal.h"
+
+#include "core_migrator.h"
+#include "dlist_it.h"
+#include "queue.internal.h"
+#include "ring.h"
+#include "svc.h"
+#include "task.h"
+#include "time.h"
+
+#include <algorithm>
+
+typedef int32_t message_size_t;
+
+qos_message_queue_t* QOS_INITIALIZATION qos_new_message_queue(int32_t capacity) {
+  auto queue = new qos_message_queue_t;
+  qos_init_message_queue(queue, new char[capacity], capacity);
+  return queue;
+}
+
+void QOS_INITIALIZATION qos_init_message_queue(qos_message_queue_t* queue, void* buffer, int32_t capacity) {
+  assert(capacity > int32_t(sizeof(message_size_t)));
+
+  queue->core = get_core_num();
+  queue->capacity = capacity;
+  queue->count = 0;
+  queue->read_idx = 0;
+  queue->write_idx = 0;
+  queue->buffer = (char*) buffer;
+
+  qos_init_dlist(&queue->read_waiting.tasks);
+  qos_init_dlist(&queue->write_waiting.tasks);
+}
+
+// Call result for a blocked task readied to retry its operation. Timed out tasks retain call result zero.
+static const int32_t RETRY = -1;
+
+static void QOS_HANDLER_MODE ready_waiting(qos_supervisor_t* supervisor, qos_task_state_t* task_state, qos_message_queue_t* queue) {
+  // Readied tasks retry; any that lose the race block again.
+  if (queue->count) {
+    auto position = begin(queue->read_waiting);
+    while (position != end(queue->read_waiting)) {
+      auto task = &*position;
+      position = remove(position);
+      qos_supervisor_call_result(supervisor, task, RETRY);
+      qos_ready_task(supervisor, task_state, task);
+    }
+  }
+
+  auto avail = queue->capacity - queue->count;
+  auto position = begin(queue->write_waiting);
+  while (position != end(queue->write_waiting)) {
+    auto task = &*position;
+    if (task->sync_state <= avail) {
+      position = remove(position);
+      qos_supervisor_call_result(supervisor, task, RETRY);
+      qos_ready_task(supervisor, task_state, task);
+    } else {
+      ++position;
+    }
+  }
+}
+
+// If gather, iov holds the parts of one message, otherwise each element of iov is a message.
+static qos_task_state_t QOS_HANDLER_MODE write_supervisor(qos_supervisor_t* supervisor, va_list args) {
+  auto queue = va_arg(args, qos_message_queue_t*);
+  auto iov = va_arg(args, const qos_iovec_t*);
+  auto iov_count = va_arg(args, int32_t);
+  auto gather = va_arg(args, int32_t);
+  auto timeout = va_arg(args, qos_time_t);
+
+  auto part_count = gather ? iov_count : 1;
+  int32_t written = 0;
+  for (auto i = 0; i < iov_count; i += part_count) {
+    message_size_t size = 0;
+    for (auto j = 0; j < part_count; ++j) {
+      size += iov[i + j].size;
+    }
+
+    // A message that could never fit fails without blocking.
+    auto needed = int32_t(sizeof(size)) + size;
+    if (needed > queue->capacity) {
+      break;
+    }
+
+    if (needed > queue->capacity - queue->count) {
+      if (written) {
+        break;
+      }
+      return qos_internal_block_on_queue(supervisor, &queue->write_waiting, nullptr, needed, timeout);
+    }
+
+    qos_ring_copy_in(queue, &size, sizeof(size));
+    for (auto j = 0; j < part_count; ++j) {
+      qos_ring_copy_in(queue, iov[i + j].data, iov[i + j].size);
+    }
+    ++written;
+  }
+
+  auto task_state = QOS_TASK_RUNNING;
+  qos_current_supervisor_call_result(supervisor, written);
+  ready_waiting(supervisor, &task_state, queue);
+  return task_state;
+}
+
+static int32_t write_message_queue(qos_message_queue_t* queue, const qos_iovec_t* iov, int32_t iov_count, bool gather, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(queue->core);
+
+  int32_t written;
+  do {
+    written = qos_call_supervisor_va(write_supervisor, queue, iov, iov_count, int32_t(gather), timeout);
+  } while (written == RETRY);
+
+  return written;
+}
+
+bool qos_write_message_queue(qos_message_queue_t* queue, const void* data, int32_t size, qos_time_t timeout) {
+  qos_iovec_t iov = { data, size };
+  return write_message_queue(queue, &iov, 1, true, timeout) != 0;
+}
+
+bool qos_writev_message_queue(qos_message_queue_t* queue, const qos_iovec_t* iov, int32_t iov_count, qos_time_t timeout) {
+  assert(iov_count > 0);
+  return write_message_queue(queue, iov, iov_count, true, timeout) != 0;
+}
+
+int32_t qos_write_many_message_queue(qos_message_queue_t* queue, const qos_iovec_t* messages, int32_t count, qos_time_t timeout) {
+  assert(count > 0);
+  return write_message_queue(queue, messages, count, false, timeout);
+}
+
+static qos_task_state_t QOS_HANDLER_MODE read_supervisor(qos_supervisor_t* supervisor, va_list args) {
+  auto queue = va_arg(args, qos_message_queue_t*);
+  auto data = va_arg(args, char*);
+  auto max_bytes = va_arg(args, int32_t);
+  auto sizes = va_arg(args, int32_t*);
+  auto max_count = va_arg(args, int32_t);
+  auto timeout = va_arg(args, qos_time_t);
+
+  if (queue->count == 0) {
+    return qos_internal_block_on_queue(supervisor, &queue->read_waiting, nullptr, 0, timeout);
+  }
+
+  int32_t read = 0;
+  while (read < max_count && queue->count) {
+    message_size_t size;
+    qos_ring_peek(queue, &size, sizeof(size));
+    if (read && size > max_bytes) {
+      break;
+    }
+
+    qos_ring_skip(queue, sizeof(size));
+
+    auto data_size = std::min(size, max_bytes);
+    qos_ring_copy_out(queue, data, data_size, size);
+    data += data_size;
+    max_bytes -= data_size;
+
+    sizes[read++] = size;
+  }
+
+  auto task_state = QOS_TASK_RUNNING;
+  qos_current_supervisor_call_result(supervisor, read);
+  ready_waiting(supervisor, &task_state, queue);
+  return task_state;
+}
+
+int32_t qos_read_many_message_queue(qos_message_queue_t* queue, void* data, int32_t max_bytes,
+                                    int32_t* sizes, int32_t max_count, qos_time_t timeout) {
+  assert(max_count > 0);
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(queue->core);
+
+  int32_t read;
+  do {
+    read = qos_call_supervisor_va(read_supervisor, queue, data, max_bytes, sizes, max_count, timeout);
+  } while (read == RETRY);
+
+  return read;
+}
+
+int32_t qos_read_message_queue(qos_message_queue_t* queue, void* data, int32_t max_size, qos_time_t timeout) {
+  int32_t size;
+  if (!qos_read_many_message_queue(queue, data, max_size, &size, 1, timeout)) {
+    return -1;
+  }
+  return size;
+}
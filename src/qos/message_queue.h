@@ -0,0 +1,39 @@
+#ifndef QOS_MESSAGE_QUEUE_H
+#define QOS_MESSAGE_QUEUE_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+typedef struct qos_iovec_t {
+  const void* data;
+  int32_t size;
+} qos_iovec_t;
+
+// Multi-producer / multi-consumer queue of variable size messages. Each message is stored in the buffer
+// preceded by its size.
+struct qos_message_queue_t* qos_new_message_queue(int32_t capacity);
+void qos_init_message_queue(struct qos_message_queue_t* queue, void* buffer, int32_t capacity);
+
+// Writes one message. A message larger than the queue, counting its size prefix, fails without blocking.
+bool qos_write_message_queue(struct qos_message_queue_t* queue, const void* data, int32_t size, qos_time_t timeout);
+
+// Writes one message gathered from iov_count parts.
+bool qos_writev_message_queue(struct qos_message_queue_t* queue, const qos_iovec_t* iov, int32_t iov_count, qos_time_t timeout);
+
+// Writes as many of count messages as fit, blocking only until the first fits. Returns number of messages written,
+// stopping at any message larger than the queue.
+int32_t qos_write_many_message_queue(struct qos_message_queue_t* queue, const qos_iovec_t* messages, int32_t count, qos_time_t timeout);
+
+// Reads one message, returning its size or -1 on timeout. Bytes of the message beyond max_size are discarded.
+int32_t qos_read_message_queue(struct qos_message_queue_t* queue, void* data, int32_t max_size, qos_time_t timeout);
+
+// Reads consecutive messages, packed into data, until max_count messages have been read, the next message would
+// exceed max_bytes or the queue is empty, blocking only until the first is available. The size of each is stored
+// in sizes. Returns number of messages read. The first message is truncated if it alone exceeds max_bytes.
+int32_t qos_read_many_message_queue(struct qos_message_queue_t* queue, void* data, int32_t max_bytes,
+                                    int32_t* sizes, int32_t max_count, qos_time_t timeout);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_MESSAGE_QUEUE_H
@@ -0,0 +1,24 @@
+#ifndef QOS_MESSAGE_QUEUE_INTERNAL_H
+#define QOS_MESSAGE_QUEUE_INTERNAL_H
+
+#include "message_queue.h"
+#include "task.internal.h"
+
+QOS_BEGIN_EXTERN_C
+
+typedef struct qos_message_queue_t {
+  int8_t core;
+  int32_t capacity;
+  int32_t count;  // includes size prefixes
+  int32_t read_idx;
+  int32_t write_idx;
+  char *buffer;
+
+  // While blocked, a writing task's sync_state is the number of bytes it needs.
+  qos_task_scheduling_dlist_t read_waiting;
+  qos_task_scheduling_dlist_t write_waiting;
+} qos_message_queue_t;
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_MESSAGE_QUEUE_INTERNAL_H
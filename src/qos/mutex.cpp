@@ -65,12 +65,10 @@ static void QOS_HANDLER_MODE pop_owned(qos_task_t* task, qos_mutex_t* mutex) {
 }
 
 
-static qos_task_state_t QOS_HANDLER_MODE acquire_mutex_supervisor(qos_supervisor_t* supervisor, va_list args) {
-  auto mutex = va_arg(args, qos_mutex_t*);
-  auto timeout = va_arg(args, qos_time_t);
-
+qos_task_state_t QOS_HANDLER_MODE qos_internal_acquire_mutex_supervisor(qos_mutex_t* mutex, qos_time_t timeout) {
   assert (timeout != 0);
 
+  auto supervisor = qos_internal_get_supervisor();
   auto current_task = supervisor->current_task;
 
   auto owner_state = mutex->owner_state;
@@ -129,7 +127,7 @@ bool qos_acquire_mutex(qos_mutex_t* mutex, qos_time_t timeout) {
     }
   }
 
-  return qos_call_supervisor_va(acquire_mutex_supervisor, mutex, timeout);
+  return qos_call_supervisor_regs(qos_internal_acquire_mutex_supervisor, mutex, timeout);
 }
 
 
@@ -177,6 +175,12 @@ static qos_task_state_t QOS_HANDLER_MODE release_mutex_supervisor(qos_supervisor
   return task_state;
 }
 
+qos_task_state_t QOS_HANDLER_MODE qos_internal_release_mutex_supervisor(qos_mutex_t* mutex) {
+  auto supervisor = qos_internal_get_supervisor();
+  pop_owned(supervisor->current_task, mutex);
+  return release_mutex_supervisor(supervisor, mutex);
+}
+
 void qos_release_mutex(qos_mutex_t* mutex) {
   qos_core_migrator migrator(mutex->core);
 
@@ -221,10 +225,8 @@ bool qos_acquire_condition_var(struct qos_condition_var_t* var, qos_time_t timeo
 }
 
 
-qos_task_state_t QOS_HANDLER_MODE qos_wait_condition_var_supervisor(qos_supervisor_t* supervisor, va_list args) {
-  auto var = va_arg(args, qos_condition_var_t*);
-  auto timeout = va_arg(args, qos_time_t);
-
+qos_task_state_t QOS_HANDLER_MODE qos_wait_condition_var_supervisor(qos_condition_var_t* var, qos_time_t timeout) {
+  auto supervisor = qos_internal_get_supervisor();
   auto current_task = supervisor->current_task;
 
   // _Atomically_ release mutex and add to condition variable waiting list.
@@ -245,7 +247,7 @@ bool qos_wait_condition_var(qos_condition_var_t* var, qos_time_t timeout) {
   qos_core_migrator migrator(var->mutex->core);
 
   assert(qos_owns_mutex(var->mutex));
-  return qos_call_supervisor_va(qos_wait_condition_var_supervisor, var, timeout);
+  return qos_call_supervisor_regs(qos_wait_condition_var_supervisor, var, timeout);
 }
 
 
@@ -19,4 +19,8 @@ typedef struct qos_condition_var_t {
   qos_task_scheduling_dlist_t waiting;
 } qos_condition_var_t;
 
+// Typed supervisor procs, also run as steps of compound supervisor calls.
+qos_task_state_t qos_internal_acquire_mutex_supervisor(qos_mutex_t* mutex, qos_time_t timeout);
+qos_task_state_t qos_internal_release_mutex_supervisor(qos_mutex_t* mutex);
+
 #endif  // QOS_MUTEX_INTERNAL_H
@@ -0,0 +1,252 @@
+#include "notify.h"
+#include "notify.internal.h"
+
+#include "atomic.h"
+#include "core_migrator.h"
+#include "dlist_it.h"
+#include "interrupt.h"
+#include "svc.h"
+#include "task.h"
+#include "time.h"
+
+#include "hardware/structs/scb.h"
+#include "hardware/structs/sio.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+
+static volatile bool g_notified_from_isr[NUM_CORES];
+
+// While a task is blocked awaiting notification, its sync_ptr points to its notification
+// word and its sync_state is the mask of bits it awaits.
+static bool QOS_HANDLER_MODE is_awaiting_notify(qos_task_t* task) {
+  return task->sync_ptr == &task->notify_value;
+}
+
+// Notifications from the other core count, though they are not yet in the notification word.
+static bool QOS_HANDLER_MODE is_notified(qos_task_t* task, uint32_t mask) {
+  return (task->notify_value | task->remote_notify) & mask;
+}
+
+static void QOS_HANDLER_MODE ready_if_notified(qos_supervisor_t* supervisor, qos_task_state_t* task_state, qos_task_t* task) {
+  if (is_awaiting_notify(task) && is_notified(task, task->sync_state)) {
+    qos_supervisor_call_result(supervisor, task, true);
+    qos_ready_task(supervisor, task_state, task);
+  }
+}
+
+static qos_task_state_t QOS_HANDLER_MODE notify_task_supervisor(qos_supervisor_t* supervisor, void* p) {
+  auto task = (qos_task_t*) p;
+  auto task_state = QOS_TASK_RUNNING;
+  ready_if_notified(supervisor, &task_state, task);
+  return task_state;
+}
+
+void QOS_HANDLER_MODE qos_internal_handle_notified_tasks_supervisor(qos_supervisor_t* supervisor, qos_task_state_t* task_state) {
+  auto core = get_core_num();
+  if (!g_notified_from_isr[core]) {
+    return;
+  }
+  g_notified_from_isr[core] = false;
+
+  auto& awaiting = supervisor->awaiting_notify;
+  auto position = begin(awaiting);
+  while (position != end(awaiting)) {
+    auto task = &*position;
+    ++position;
+    ready_if_notified(supervisor, task_state, task);
+  }
+}
+
+static void wake_notified_task(qos_task_t* task) {
+  // The notification word was updated before this test so, if the task is not yet awaiting
+  // notification, it will observe the update before it blocks.
+  if (is_awaiting_notify(task)) {
+    qos_call_supervisor(notify_task_supervisor, task);
+  }
+}
+
+// Like events, notifications of a task on the other core are posted through the inter-core FIFO rather than by
+// migrating. The supervisor of the task's core does not add them to the notification word, since ISRs might
+// preempt it doing so; the task adds them itself, in thread mode, with atomic operations.
+void QOS_HANDLER_MODE qos_internal_ready_if_remotely_notified(qos_supervisor_t* supervisor, qos_task_state_t* task_state, qos_task_t* task) {
+  // The task might have migrated to the notifying core after the notifier checked. It was then running rather than
+  // awaiting, so will observe remote_notify when it next awaits.
+  if (task->core != get_core_num()) {
+    return;
+  }
+  ready_if_notified(supervisor, task_state, task);
+}
+
+static qos_task_state_t QOS_HANDLER_MODE notify_remote_supervisor(qos_task_t* task, uint32_t bits, bool increment) {
+  // Caller retries until the FIFO is ready. ISRs never write the FIFO and tasks that do are not running, so it
+  // cannot fill in the meantime.
+  if (!multicore_fifo_wready()) {
+    return QOS_TASK_READY;
+  }
+
+  auto lock = spin_lock_instance(QOS_REMOTE_NOTIFY_SPINLOCK);
+  spin_lock_unsafe_blocking(lock);
+  if (increment) {
+    ++task->remote_notify;
+  } else {
+    task->remote_notify |= bits;
+  }
+  spin_unlock_unsafe(lock);
+
+  sio_hw->fifo_wr = intptr_t(&task->ready_handler) | QOS_FIFO_NOTIFY_TAG;
+  __sev();
+
+  qos_current_supervisor_call_result(qos_internal_get_supervisor(), true);
+  return QOS_TASK_RUNNING;
+}
+
+static void notify_remote(qos_task_t* task, uint32_t bits, bool increment) {
+  while (!qos_call_supervisor_regs(notify_remote_supervisor, task, bits, increment)) {
+  }
+}
+
+static qos_task_state_t QOS_HANDLER_MODE take_remote_notify_supervisor(qos_supervisor_t* supervisor, void*) {
+  auto task = supervisor->current_task;
+
+  auto lock = spin_lock_instance(QOS_REMOTE_NOTIFY_SPINLOCK);
+  spin_lock_unsafe_blocking(lock);
+  auto value = task->remote_notify;
+  task->remote_notify = 0;
+  spin_unlock_unsafe(lock);
+
+  qos_current_supervisor_call_result(supervisor, value);
+  return QOS_TASK_RUNNING;
+}
+
+// Returns, and removes, the calling task's notifications from the other core.
+static uint32_t take_remote_notify(qos_task_t* task) {
+  if (!task->remote_notify) {
+    return 0;
+  }
+  return qos_call_supervisor(take_remote_notify_supervisor, nullptr);
+}
+
+void qos_notify_task(qos_task_t* task, uint32_t bits) {
+  if (task->core != get_core_num()) {
+    notify_remote(task, bits, false);
+    return;
+  }
+
+  int32_t old_value;
+  do {
+    old_value = task->notify_value;
+  } while (qos_atomic_compare_and_set(&task->notify_value, old_value, old_value | bits) != old_value);
+
+  wake_notified_task(task);
+}
+
+void qos_increment_task_notify(qos_task_t* task) {
+  if (task->core != get_core_num()) {
+    notify_remote(task, 0, true);
+    return;
+  }
+
+  qos_atomic_add(&task->notify_value, 1);
+
+  wake_notified_task(task);
+}
+
+static void QOS_HANDLER_MODE wake_notified_task_from_isr() {
+  // Unlike wake_notified_task, always pend PendSV; this ISR might have preempted
+  // await_notify_supervisor after it tested the notification word.
+  g_notified_from_isr[get_core_num()] = true;
+  scb_hw->icsr = M0PLUS_ICSR_PENDSVSET_BITS;
+}
+
+// Must call qos_roll_back_atomic_from_isr() first.
+void QOS_HANDLER_MODE qos_notify_task_from_isr(qos_task_t* task, uint32_t bits) {
+  assert(task->core == get_core_num());
+  task->notify_value |= bits;
+  wake_notified_task_from_isr();
+}
+
+// Must call qos_roll_back_atomic_from_isr() first.
+void QOS_HANDLER_MODE qos_increment_task_notify_from_isr(qos_task_t* task) {
+  assert(task->core == get_core_num());
+  ++task->notify_value;
+  wake_notified_task_from_isr();
+}
+
+static qos_task_state_t QOS_HANDLER_MODE await_notify_supervisor(uint32_t mask, qos_time_t timeout) {
+  assert(timeout != 0);
+
+  auto supervisor = qos_internal_get_supervisor();
+  auto current_task = supervisor->current_task;
+
+  if (is_notified(current_task, mask)) {
+    qos_current_supervisor_call_result(supervisor, true);
+    return QOS_TASK_RUNNING;
+  }
+
+  current_task->sync_ptr = &current_task->notify_value;
+  current_task->sync_state = mask;
+
+  qos_internal_insert_scheduled_task(&supervisor->awaiting_notify, current_task);
+  qos_delay_task(supervisor, current_task, timeout);
+
+  return QOS_TASK_SYNC_BLOCKED;
+}
+
+static bool await_notify(qos_task_t* task, uint32_t mask, qos_time_t timeout) {
+  if ((task->notify_value | task->remote_notify) & mask) {
+    return true;
+  }
+
+  if (timeout == 0) {
+    return false;
+  }
+
+  return qos_call_supervisor_regs(await_notify_supervisor, mask, timeout);
+}
+
+uint32_t qos_await_notify_bits(uint32_t mask, qos_time_t timeout) {
+  assert(mask);
+  qos_normalize_time(&timeout);
+
+  auto task = qos_current_task();
+  qos_core_migrator migrator(task->core);
+
+  for (;;) {
+    if (!await_notify(task, mask, timeout)) {
+      return 0;
+    }
+
+    auto remote = take_remote_notify(task);
+    if (remote) {
+      qos_atomic_fetch_or(&task->notify_value, remote);
+    }
+
+    int32_t old_value = task->notify_value;
+    if (qos_atomic_compare_and_set(&task->notify_value, old_value, old_value & ~mask) == old_value) {
+      return old_value & mask;
+    }
+  }
+}
+
+uint32_t qos_await_notify_count(bool clear, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  auto task = qos_current_task();
+  qos_core_migrator migrator(task->core);
+
+  for (;;) {
+    if (!await_notify(task, UINT32_MAX, timeout)) {
+      return 0;
+    }
+
+    auto remote = take_remote_notify(task);
+    if (remote) {
+      qos_atomic_add(&task->notify_value, remote);
+    }
+
+    int32_t old_value = task->notify_value;
+    if (qos_atomic_compare_and_set(&task->notify_value, old_value, clear ? 0 : old_value - 1) == old_value) {
+      return old_value;
+    }
+  }
+}
@@ -0,0 +1,23 @@
+#ifndef QOS_NOTIFY_H
+#define QOS_NOTIFY_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+struct qos_task_t;
+
+// Each task has a notification word, which may be used either as a set of bits or as a counter. Notifications from
+// the other core are held apart until the task awaits, so must not mix bits and increments.
+void qos_notify_task(struct qos_task_t* task, uint32_t bits);
+void qos_notify_task_from_isr(struct qos_task_t* task, uint32_t bits);
+void qos_increment_task_notify(struct qos_task_t* task);
+void qos_increment_task_notify_from_isr(struct qos_task_t* task);
+
+// Called by the task owning the notification word.
+uint32_t qos_await_notify_bits(uint32_t mask, qos_time_t timeout);
+uint32_t qos_await_notify_count(bool clear, qos_time_t timeout);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_NOTIFY_H
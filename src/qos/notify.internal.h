@@ -0,0 +1,14 @@
+#ifndef QOS_NOTIFY_INTERNAL_H
+#define QOS_NOTIFY_INTERNAL_H
+
+#include "notify.h"
+#include "task.internal.h"
+
+QOS_BEGIN_EXTERN_C
+
+void qos_internal_handle_notified_tasks_supervisor(qos_supervisor_t* supervisor, qos_task_state_t* task_state);
+void qos_internal_ready_if_remotely_notified(qos_supervisor_t* supervisor, qos_task_state_t* task_state, qos_task_t* task);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_NOTIFY_INTERNAL_H
@@ -4,6 +4,8 @@
 #include "task.h"
 #include "task.internal.h"
 
+#if QOS_TASK_PARALLEL
+
 static qos_task_state_t QOS_HANDLER_MODE suspend_supervisor(qos_supervisor_t* supervisor, void* p) {
   auto done = (qos_proc_int32_t*) p;
   *done = nullptr;
@@ -31,7 +33,7 @@ void qos_init_parallel(int32_t parallel_stack_size) {
   current_task->stack += parallel_stack_size;
   auto parallel_task = (qos_task_t*) current_task->stack;
   current_task->stack += sizeof(*parallel_task);
-  current_task->stack_size -= sizeof(sizeof(*parallel_task)) + parallel_stack_size;
+  current_task->stack_size -= sizeof(*parallel_task) + parallel_stack_size;
 
   qos_init_task(parallel_task, current_task->priority, run_parallel, parallel_stack, parallel_stack_size);
   current_task->parallel_task = parallel_task;
@@ -49,3 +51,4 @@ void QOS_TIME_CRITICAL qos_parallel(qos_proc_int32_t entry) {
   while (parallel_task->parallel_entry) {}
 }
 
+#endif  // QOS_TASK_PARALLEL
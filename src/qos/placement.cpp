@@ -0,0 +1,114 @@
+#include "placement.h"
+
+#include <cassert>
+
+#include "hardware/regs/addressmap.h"
+#include "pico/mutex.h"
+
+#define NUM_BANKS 6
+#define BANK_SIZE 0x10000
+#define SCRATCH_BANK_SIZE 0x1000
+
+struct arena_t {
+  char* next;
+  char* end;
+};
+
+static arena_t g_arenas[NUM_BANKS];
+static bool g_scratch_arenas_initialized;
+
+// Either core may allocate from any bank so arenas are serialized by a mutex. Placement is expected to happen mostly
+// during initialization.
+auto_init_mutex(g_arena_mutex);
+
+static intptr_t get_bank_base(int32_t bank) {
+  static const intptr_t bases[NUM_BANKS] = { SRAM0_BASE, SRAM1_BASE, SRAM2_BASE, SRAM3_BASE, SRAM4_BASE, SRAM5_BASE };
+  return bases[bank];
+}
+
+static int32_t get_bank_size(int32_t bank) {
+  return bank >= 4 ? SCRATCH_BANK_SIZE : BANK_SIZE;
+}
+
+static void init_arena(int32_t bank, char* begin, char* end) {
+  auto& arena = g_arenas[bank];
+  arena.next = (char*) ((intptr_t(begin) + 7) & ~7);
+  arena.end = end;
+}
+
+static void init_scratch_arenas() {
+  if (g_scratch_arenas_initialized) {
+    return;
+  }
+
+  // Free space between the .scratch_x / .scratch_y sections and the bottom of the initial stack of each core.
+  extern char __scratch_x_end__, __StackOneBottom;
+  extern char __scratch_y_end__, __StackBottom;
+  init_arena(4, &__scratch_x_end__, &__StackOneBottom);
+  init_arena(5, &__scratch_y_end__, &__StackBottom);
+
+  g_scratch_arenas_initialized = true;
+}
+
+void qos_init_bank_arena(int32_t bank, void* buffer, int32_t size) {
+  assert(bank >= 0 && bank < 4);
+  assert(qos_get_bank(buffer) == bank);
+  assert(qos_get_bank((char*) buffer + size - 1) == bank);
+
+  mutex_enter_blocking(&g_arena_mutex);
+  init_arena(bank, (char*) buffer, (char*) buffer + size);
+  mutex_exit(&g_arena_mutex);
+}
+
+static void* allocate_in_bank(int32_t bank, int32_t size) {
+  mutex_enter_blocking(&g_arena_mutex);
+
+  init_scratch_arenas();
+
+  void* p = nullptr;
+  auto& arena = g_arenas[bank];
+  if (arena.next && arena.end - arena.next >= size) {
+    p = arena.next;
+    arena.next += (size + 7) & ~7;
+  }
+
+  mutex_exit(&g_arena_mutex);
+  return p;
+}
+
+// Tasks migrate between cores so the local scratch bank is only used if the MPU does not prevent the other core
+// accessing it.
+static int32_t get_local_bank() {
+  if (get_core_num() == 0) {
+    return QOS_PROTECT_CORE0_SCRATCH_BANK ? -1 : 5;
+  } else {
+    return QOS_PROTECT_CORE1_SCRATCH_BANK ? -1 : 4;
+  }
+}
+
+void* qos_allocate_placed(qos_placement_t placement, int32_t size) {
+  assert(size >= 0);
+
+  if (placement == QOS_PLACE_LOCAL) {
+    auto bank = get_local_bank();
+    void* p = bank >= 0 ? allocate_in_bank(bank, size) : nullptr;
+    return p ? p : new int64_t[(size + 7) / 8];
+  }
+
+  if (placement == QOS_PLACE_STRIPED) {
+    return new int64_t[(size + 7) / 8];
+  }
+
+  assert(placement >= 0 && placement < NUM_BANKS);
+  return allocate_in_bank(placement, size);
+}
+
+int32_t qos_get_bank(const void* p) {
+  for (auto bank = 0; bank < NUM_BANKS; ++bank) {
+    auto offset = intptr_t(p) - get_bank_base(bank);
+    if (offset >= 0 && offset < get_bank_size(bank)) {
+      return bank;
+    }
+  }
+  return -1;
+}
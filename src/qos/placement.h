@@ -0,0 +1,30 @@
+#ifndef QOS_PLACEMENT_H
+#define QOS_PLACEMENT_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+// Where in SRAM an object is allocated. Values 0-5 select an SRAM bank: the non-striped aliases of SRAM0-SRAM3 or
+// scratch banks SRAM4 (core 1's) and SRAM5 (core 0's).
+typedef enum qos_placement_t {
+  QOS_PLACE_STRIPED = -2,   // striped SRAM0-SRAM3, allocated with new
+  QOS_PLACE_LOCAL = -1,     // scratch bank of the calling core if it has room and the other core may access it, otherwise striped
+} qos_placement_t;
+
+#define QOS_PLACE_BANK(bank) ((qos_placement_t) (bank))
+
+// Memory in SRAM0-SRAM3 is only available for placement once an arena is given for the bank. Since striped SRAM
+// interleaves every bank, this usually needs a linker script that reserves the bank. The arenas of scratch banks
+// SRAM4 and SRAM5 comprise the part of each bank not used by the linker or the initial stack.
+void qos_init_bank_arena(int32_t bank, void* buffer, int32_t size);
+
+// Allocates 8 byte aligned memory that is never freed. Returns null if the bank's arena is exhausted.
+void* qos_allocate_placed(qos_placement_t placement, int32_t size);
+
+// Returns the SRAM bank containing an address or -1 if in striped SRAM or not in SRAM.
+int32_t qos_get_bank(const void* p);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_PLACEMENT_H
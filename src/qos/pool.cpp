@@ -0,0 +1,227 @@
+#include "pool.h"
+#include "pool.internal.h"
+
+#include "atomic.h"
+#include "core_migrator.h"
+#include "event.h"
+#include "interrupt.h"
+#include "time.h"
+
+#include <cassert>
+#include <cstddef>
+
+#include "hardware/sync.h"
+
+struct block_t {
+  block_t* next;
+};
+
+static void QOS_HANDLER_MODE flush_handler(qos_supervisor_t* supervisor, qos_task_state_t* task_state, intptr_t handler);
+
+qos_pool_t* QOS_INITIALIZATION qos_new_pool(int32_t count, int32_t block_size, bool blocking) {
+  auto pool = new qos_pool_t;
+  auto buffer = new int64_t[QOS_POOL_BUFFER_SIZE(count, block_size) / sizeof(int64_t)];
+  qos_init_pool(pool, buffer, count, block_size, blocking);
+  return pool;
+}
+
+void QOS_INITIALIZATION qos_init_pool(qos_pool_t* pool, void* buffer, int32_t count, int32_t block_size, bool blocking) {
+  assert(count > 0);
+  assert(block_size > 0);
+  assert((uintptr_t(buffer) & 7) == 0);
+
+  pool->core = get_core_num();
+  pool->blocking = blocking;
+  pool->waiting = 0;
+
+  for (auto i = 0; i < NUM_CORES; ++i) {
+    pool->deferred[i] = nullptr;
+    pool->returned[i] = nullptr;
+    pool->flush_requested[i] = false;
+  }
+  pool->flush_handler = flush_handler;
+
+  auto stride = (block_size + 7) & ~7;
+  block_t* next = nullptr;
+  for (auto i = count - 1; i >= 0; --i) {
+    auto block = (block_t*) ((char*) buffer + i * stride);
+    block->next = next;
+    next = block;
+  }
+  pool->free = next;
+
+  if (blocking) {
+    qos_init_event(&pool->available, pool->core);
+  }
+}
+
+// Pushes a chain of blocks, in one step if the list is empty.
+static void push_chain(qos_atomic_ptr_t* head, block_t* chain) {
+  if (qos_atomic_compare_and_set_ptr(head, nullptr, chain) == nullptr) {
+    return;
+  }
+
+  while (chain) {
+    auto next = chain->next;
+    qos_atomic_push(head, chain);
+    chain = next;
+  }
+}
+
+// Must run on the pool's core.
+static void* try_allocate(qos_pool_t* pool) {
+  auto block = (block_t*) qos_atomic_pop(&pool->free);
+  if (block) {
+    return block;
+  }
+
+  // Free list is empty so take a batch returned by another core, if any.
+  for (auto i = 0; i < NUM_CORES; ++i) {
+    if (i == pool->core) {
+      continue;
+    }
+
+    // Only the other core stores to returned[i] and only while it is null, so it may only be cleared once observed
+    // non-null; an unconditional exchange could overwrite a chain stored in between. Compare-and-set, rather than a
+    // plain store, because another task on this core might take the same chain.
+    block = (block_t*) pool->returned[i];
+    if (block && qos_atomic_compare_and_set_ptr(&pool->returned[i], block, nullptr) == block) {
+      __dmb();
+      if (block->next) {
+        push_chain(&pool->free, block->next);
+      }
+      return block;
+    }
+  }
+
+  return nullptr;
+}
+
+// Runs on the pool's core in thread mode. A core that freed blocks while returned[i] was occupied only hands them
+// over when it next frees a block, so it is asked to hand them over now.
+static void request_flushes(qos_pool_t* pool) {
+  __dmb();
+  for (auto i = 0; i < NUM_CORES; ++i) {
+    if (i == pool->core || !pool->deferred[i] || pool->returned[i] || pool->flush_requested[i]) {
+      continue;
+    }
+
+    pool->flush_requested[i] = true;
+    __dmb();
+    qos_internal_atomic_write_fifo(&pool->flush_handler);
+  }
+}
+
+// Runs on a core other than the pool's. Only tasks of this core access deferred[core], with atomic operations,
+// which this handler might have preempted.
+static void QOS_HANDLER_MODE flush_handler(qos_supervisor_t* supervisor, qos_task_state_t* task_state, intptr_t handler) {
+  auto pool = (qos_pool_t*) (handler - offsetof(qos_pool_t, flush_handler));
+  auto core = get_core_num();
+
+  // Cleared first so a request made after the blocks are handed over is not lost.
+  pool->flush_requested[core] = false;
+  __dmb();
+
+  if (pool->returned[core]) {
+    return;
+  }
+
+  qos_roll_back_atomic_from_isr();
+  auto chain = pool->deferred[core];
+  if (!chain) {
+    return;
+  }
+  pool->deferred[core] = nullptr;
+
+  __dmb();
+  pool->returned[core] = chain;
+
+  __dmb();
+  if (pool->waiting) {
+    qos_signal_event_from_isr(&pool->available);
+  }
+}
+
+// Returns true if the pool might have become able to satisfy an allocation.
+static bool free_block(qos_pool_t* pool, void* block) {
+  auto core = get_core_num();
+  if (core == pool->core) {
+    qos_atomic_push(&pool->free, block);
+    return true;
+  }
+
+  // Cross-core free. There are no inter-core atomic instructions so blocks accumulate on this core until the pool's
+  // core has taken the previous batch.
+  qos_atomic_push(&pool->deferred[core], block);
+
+  auto chain = (block_t*) qos_atomic_exchange_ptr(&pool->deferred[core], nullptr);
+  if (!chain) {
+    return false;
+  }
+
+  __dmb();
+  if (qos_atomic_compare_and_set_ptr(&pool->returned[core], nullptr, chain) == nullptr) {
+    return true;
+  }
+
+  push_chain(&pool->deferred[core], chain);
+  return false;
+}
+
+void* qos_allocate_pool_block(qos_pool_t* pool, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(pool->core);
+
+  auto block = try_allocate(pool);
+  request_flushes(pool);
+  if (block || timeout == 0) {
+    return block;
+  }
+
+  assert(pool->blocking);
+
+  // Signallers free a block before testing waiting, so at least one of the two observes the other.
+  qos_atomic_add(&pool->waiting, 1);
+  __dmb();
+
+  for (;;) {
+    block = try_allocate(pool);
+    request_flushes(pool);
+    if (block) {
+      break;
+    }
+
+    if (!qos_await_event(&pool->available, timeout)) {
+      break;
+    }
+  }
+
+  qos_atomic_add(&pool->waiting, -1);
+  return block;
+}
+
+void qos_free_pool_block(qos_pool_t* pool, void* block) {
+  if (free_block(pool, block)) {
+    __dmb();
+    if (pool->waiting) {
+      qos_signal_event(&pool->available);
+    }
+  }
+}
+
+void* QOS_HANDLER_MODE qos_allocate_pool_block_from_isr(qos_pool_t* pool) {
+  assert(get_core_num() == pool->core);
+  return try_allocate(pool);
+}
+
+void QOS_HANDLER_MODE qos_free_pool_block_from_isr(qos_pool_t* pool, void* block) {
+  // Otherwise it would race with flush_handler, which ISRs might preempt.
+  assert(get_core_num() == pool->core);
+  if (free_block(pool, block)) {
+    __dmb();
+    if (pool->waiting) {
+      qos_signal_event_from_isr(&pool->available);
+    }
+  }
+}
@@ -0,0 +1,30 @@
+#ifndef QOS_POOL_H
+#define QOS_POOL_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+// Size in bytes of the buffer needed by a pool of count blocks, each of block_size bytes.
+#define QOS_POOL_BUFFER_SIZE(count, block_size) ((count) * (((block_size) + 7) & ~7))
+
+// Fixed-block allocator with affinity to the core on which it was initialized. If blocking, the pool uses one of its
+// core's events so that tasks can wait for a block to be freed.
+struct qos_pool_t* qos_new_pool(int32_t count, int32_t block_size, bool blocking);
+void qos_init_pool(struct qos_pool_t* pool, void* buffer, int32_t count, int32_t block_size, bool blocking);
+
+// Returns a block, or null on timeout. Timeout must be zero unless the pool is blocking.
+void* qos_allocate_pool_block(struct qos_pool_t* pool, qos_time_t timeout);
+
+// May be called on any core. Blocks freed on other than the pool's core are returned to it in batches. When
+// allocating in a task finds blocks still held by the other core, it asks that core to return them.
+void qos_free_pool_block(struct qos_pool_t* pool, void* block);
+
+// Must call qos_roll_back_atomic_from_isr() first. All ISRs using a given pool must have the same priority. Only
+// possible on the pool's core; allocation never blocks.
+void* qos_allocate_pool_block_from_isr(struct qos_pool_t* pool);
+void qos_free_pool_block_from_isr(struct qos_pool_t* pool, void* block);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_POOL_H
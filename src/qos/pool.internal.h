@@ -0,0 +1,33 @@
+#ifndef QOS_POOL_INTERNAL_H
+#define QOS_POOL_INTERNAL_H
+
+#include "pool.h"
+
+#include "event.internal.h"
+
+QOS_BEGIN_EXTERN_C
+
+typedef struct qos_pool_t {
+  int8_t core;
+  bool blocking;
+
+  // Singly linked free blocks, modified only on the pool's core.
+  qos_atomic_ptr_t free;
+
+  // Blocks freed on core i (not the pool's core) are collected in deferred[i], which is only accessed on core i.
+  // When returned[i] is null, core i moves them there, from where the pool's core takes them. If they are still
+  // deferred once the pool's core has taken returned[i], it sets flush_requested[i] and asks core i, through the
+  // inter-core FIFO, to run flush_handler, which moves them.
+  qos_atomic_ptr_t deferred[NUM_CORES];
+  qos_atomic_ptr_t returned[NUM_CORES];
+  volatile bool flush_requested[NUM_CORES];
+  qos_fifo_handler_t flush_handler;
+
+  // Number of tasks awaiting available; modified only on the pool's core.
+  qos_atomic32_t waiting;
+  qos_event_t available;
+} qos_pool_t;
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_POOL_INTERNAL_H
@@ -0,0 +1,164 @@
+#include "priority_queue.h"
+#include "priority_queue.internal.h"
+
+#include "queue.internal.h"
+
+#include "core_migrator.h"
+#include "dlist_it.h"
+#include "svc.h"
+#include "task.h"
+#include "time.h"
+
+#include <cstring>
+
+static_assert(QOS_PRIORITY_QUEUE_BUFFER_SIZE(1, 0) == sizeof(qos_priority_queue_entry_t));
+
+qos_priority_queue_t* QOS_INITIALIZATION qos_new_priority_queue(int32_t capacity, int32_t message_size) {
+  auto queue = new qos_priority_queue_t;
+  qos_init_priority_queue(queue, new char[QOS_PRIORITY_QUEUE_BUFFER_SIZE(capacity, message_size)], capacity, message_size);
+  return queue;
+}
+
+void QOS_INITIALIZATION qos_init_priority_queue(qos_priority_queue_t* queue, void* buffer, int32_t capacity, int32_t message_size) {
+  assert(capacity > 0);
+  assert(message_size > 0);
+  assert((uintptr_t(buffer) & 3) == 0);
+
+  queue->core = get_core_num();
+  queue->capacity = capacity;
+  queue->message_size = message_size;
+  queue->count = 0;
+  queue->next_sequence = 0;
+  queue->heap = (qos_priority_queue_entry_t*) buffer;
+  queue->slots = (char*) (queue->heap + capacity);
+
+  for (auto i = 0; i < capacity; ++i) {
+    queue->heap[i].slot = i;
+  }
+
+  qos_init_dlist(&queue->read_waiting.tasks);
+  qos_init_dlist(&queue->write_waiting.tasks);
+}
+
+static bool QOS_HANDLER_MODE precedes(const qos_priority_queue_entry_t& a, const qos_priority_queue_entry_t& b) {
+  if (a.priority != b.priority) {
+    return a.priority > b.priority;
+  }
+  return int32_t(a.sequence - b.sequence) < 0;
+}
+
+static void QOS_HANDLER_MODE push(qos_priority_queue_t* queue, const void* data, int32_t priority) {
+  auto heap = queue->heap;
+  auto idx = queue->count++;
+
+  qos_priority_queue_entry_t entry = { priority, queue->next_sequence++, heap[idx].slot };
+  memcpy(&queue->slots[entry.slot * queue->message_size], data, queue->message_size);
+
+  while (idx > 0) {
+    auto parent = (idx - 1) / 2;
+    if (!precedes(entry, heap[parent])) {
+      break;
+    }
+    heap[idx] = heap[parent];
+    idx = parent;
+  }
+  heap[idx] = entry;
+}
+
+static void QOS_HANDLER_MODE pop(qos_priority_queue_t* queue, void* data) {
+  auto heap = queue->heap;
+  auto top_slot = heap[0].slot;
+  memcpy(data, &queue->slots[top_slot * queue->message_size], queue->message_size);
+
+  auto count = --queue->count;
+  auto entry = heap[count];
+
+  int32_t idx = 0;
+  for (;;) {
+    auto child = idx * 2 + 1;
+    if (child >= count) {
+      break;
+    }
+    if (child + 1 < count && precedes(heap[child + 1], heap[child])) {
+      ++child;
+    }
+    if (!precedes(heap[child], entry)) {
+      break;
+    }
+    heap[idx] = heap[child];
+    idx = child;
+  }
+  heap[idx] = entry;
+
+  // The position just beyond the heap now holds the freed slot.
+  heap[count].slot = top_slot;
+}
+
+// Completes the operations of blocked tasks directly into or out of their buffers for as long as any can make
+// progress, so that each readied task need not make a further supervisor call.
+static void QOS_HANDLER_MODE transfer_waiting(qos_supervisor_t* supervisor, qos_task_state_t* task_state, qos_priority_queue_t* queue) {
+  for (;;) {
+    if (queue->count && !empty(begin(queue->read_waiting))) {
+      auto task = &*begin(queue->read_waiting);
+      pop(queue, (void*) task->sync_ptr);
+      qos_supervisor_call_result(supervisor, task, true);
+      qos_ready_task(supervisor, task_state, task);
+    } else if (queue->count < queue->capacity && !empty(begin(queue->write_waiting))) {
+      auto task = &*begin(queue->write_waiting);
+      push(queue, (const void*) task->sync_ptr, task->sync_state);
+      qos_supervisor_call_result(supervisor, task, true);
+      qos_ready_task(supervisor, task_state, task);
+    } else {
+      break;
+    }
+  }
+}
+
+static qos_task_state_t QOS_HANDLER_MODE write_queue_supervisor(qos_supervisor_t* supervisor, va_list args) {
+  auto queue = va_arg(args, qos_priority_queue_t*);
+  auto data = va_arg(args, const void*);
+  auto priority = va_arg(args, int32_t);
+  auto timeout = va_arg(args, qos_time_t);
+
+  if (queue->count == queue->capacity) {
+    return qos_internal_block_on_queue(supervisor, &queue->write_waiting, data, priority, timeout);
+  }
+
+  auto task_state = QOS_TASK_RUNNING;
+  push(queue, data, priority);
+  qos_current_supervisor_call_result(supervisor, true);
+  transfer_waiting(supervisor, &task_state, queue);
+  return task_state;
+}
+
+bool qos_write_priority_queue(qos_priority_queue_t* queue, const void* data, int32_t priority, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(queue->core);
+
+  return qos_call_supervisor_va(write_queue_supervisor, queue, data, priority, timeout);
+}
+
+static qos_task_state_t QOS_HANDLER_MODE read_queue_supervisor(qos_supervisor_t* supervisor, va_list args) {
+  auto queue = va_arg(args, qos_priority_queue_t*);
+  auto data = va_arg(args, void*);
+  auto timeout = va_arg(args, qos_time_t);
+
+  if (queue->count == 0) {
+    return qos_internal_block_on_queue(supervisor, &queue->read_waiting, data, 0, timeout);
+  }
+
+  auto task_state = QOS_TASK_RUNNING;
+  pop(queue, data);
+  qos_current_supervisor_call_result(supervisor, true);
+  transfer_waiting(supervisor, &task_state, queue);
+  return task_state;
+}
+
+bool qos_read_priority_queue(qos_priority_queue_t* queue, void* data, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(queue->core);
+
+  return qos_call_supervisor_va(read_queue_supervisor, queue, data, timeout);
+}
@@ -0,0 +1,20 @@
+#ifndef QOS_PRIORITY_QUEUE_H
+#define QOS_PRIORITY_QUEUE_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+// Size in bytes of the buffer needed by a priority queue of capacity messages, each of message_size bytes.
+#define QOS_PRIORITY_QUEUE_BUFFER_SIZE(capacity, message_size) ((capacity) * (12 + (message_size)))
+
+// Multi-producer / multi-consumer queue of fixed size messages, each with a priority. Readers receive the
+// message with highest priority first and, among messages of equal priority, the one written first.
+struct qos_priority_queue_t* qos_new_priority_queue(int32_t capacity, int32_t message_size);
+void qos_init_priority_queue(struct qos_priority_queue_t* queue, void* buffer, int32_t capacity, int32_t message_size);
+bool qos_write_priority_queue(struct qos_priority_queue_t* queue, const void* data, int32_t priority, qos_time_t timeout);
+bool qos_read_priority_queue(struct qos_priority_queue_t* queue, void* data, qos_time_t timeout);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_PRIORITY_QUEUE_H
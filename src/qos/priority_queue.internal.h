@@ -0,0 +1,33 @@
+#ifndef QOS_PRIORITY_QUEUE_INTERNAL_H
+#define QOS_PRIORITY_QUEUE_INTERNAL_H
+
+#include "priority_queue.h"
+#include "task.internal.h"
+
+QOS_BEGIN_EXTERN_C
+
+typedef struct qos_priority_queue_entry_t {
+  int32_t priority;
+  uint32_t sequence;  // breaks ties between messages of equal priority
+  int32_t slot;       // index of message data in slots
+} qos_priority_queue_entry_t;
+
+typedef struct qos_priority_queue_t {
+  int8_t core;
+  int32_t capacity;
+  int32_t message_size;
+  qos_atomic32_t count;
+  uint32_t next_sequence;
+
+  // Binary heap of count entries. Entries beyond count hold the slots of free messages.
+  qos_priority_queue_entry_t* heap;
+  char* slots;
+
+  // While blocked, a task's sync_ptr is its data buffer. A blocked writer's sync_state is its message's priority.
+  qos_task_scheduling_dlist_t read_waiting;
+  qos_task_scheduling_dlist_t write_waiting;
+} qos_priority_queue_t;
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_PRIORITY_QUEUE_INTERNAL_H
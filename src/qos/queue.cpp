@@ -2,14 +2,38 @@
 #include "queue.internal.h"
 
 #include "core_migrator.h"
-#include "semaphore.h"
-#include "mutex.h"
-#include "mutex.internal.h"
+#include "dlist_it.h"
+#include "ring.h"
+#include "svc.h"
 #include "task.h"
 #include "time.h"
 
 #include <algorithm>
-#include <cstring>
+
+#include "hardware/structs/scb.h"
+#include "hardware/sync.h"
+
+static qos_queue_t* g_waited_queues[NUM_CORES];
+static volatile bool g_accessed_from_isr[NUM_CORES];
+
+// Marks a queue busy while the supervisor modifies it. A batch might already have marked it busy for longer, so the
+// previous value is restored.
+class busy_scope {
+public:
+  explicit busy_scope(qos_queue_t* queue): queue(queue), was_busy(queue->busy) {
+    queue->busy = true;
+    __dmb();
+  }
+
+  ~busy_scope() {
+    __dmb();
+    queue->busy = was_busy;
+  }
+
+private:
+  qos_queue_t* queue;
+  bool was_busy;
+};
 
 qos_queue_t* QOS_INITIALIZATION qos_new_queue(int32_t capacity) {
   auto queue = new qos_queue_t;
@@ -17,77 +41,277 @@ qos_queue_t* QOS_INITIALIZATION qos_new_queue(int32_t capacity) {
   return queue;
 }
 
+// Only the buffer is placed; the queue object is in striped SRAM.
+qos_queue_t* QOS_INITIALIZATION qos_new_queue_placed(int32_t capacity, qos_placement_t placement) {
+  auto buffer = qos_allocate_placed(placement, capacity);
+  if (!buffer) {
+    return nullptr;
+  }
+
+  auto queue = new qos_queue_t;
+  qos_init_queue(queue, buffer, capacity);
+  return queue;
+}
+
 void QOS_INITIALIZATION qos_init_queue(qos_queue_t* queue, void* buffer, int32_t capacity) {
+  qos_internal_init_queue(queue, buffer, capacity, get_core_num());
+}
+
+void QOS_INITIALIZATION qos_internal_init_queue(qos_queue_t* queue, void* buffer, int32_t capacity, int32_t core) {
   assert(capacity > 0);
-  
-  qos_init_semaphore(&queue->read_semaphore, 0);
-  qos_init_semaphore(&queue->write_semaphore, capacity);
-  qos_init_mutex(&queue->mutex, QOS_AUTO_PRIORITY_CEILING);
 
+  queue->core = core;
   queue->capacity = capacity;
+  queue->count = 0;
   queue->read_idx = 0;
   queue->write_idx = 0;
   queue->buffer = (char*) buffer;
+
+  qos_init_dlist(&queue->read_waiting.tasks);
+  qos_init_dlist(&queue->write_waiting.tasks);
+
+  queue->busy = false;
+  queue->waited = false;
+  queue->next_waited = nullptr;
 }
 
-bool qos_write_queue(qos_queue_t* queue, const void* data, int32_t size, qos_time_t timeout) {
-  qos_normalize_time(&timeout);
+// Completes the operations of blocked tasks directly into or out of their buffers for as long as any can make
+// progress, so that each readied task need not make a further supervisor call. Waiters are served strictly in
+// priority order: a waiter that cannot yet proceed holds back those behind it, so large transfers are not starved
+// by smaller blocked ones. A task that finds room or data when it calls may still overtake waiters.
+static void QOS_HANDLER_MODE transfer_waiting(qos_supervisor_t* supervisor, qos_task_state_t* task_state, qos_queue_t* queue) {
+  bool progress;
+  do {
+    progress = false;
 
-  // This isn't actually needed but it reduces the number of task migrations.
-  qos_core_migrator migrator(queue->mutex.core);
+    while (!empty(begin(queue->read_waiting))) {
+      auto task = &*begin(queue->read_waiting);
+      if (task->sync_state > queue->count) {
+        break;
+      }
 
-  if (!qos_acquire_semaphore(&queue->write_semaphore, size, timeout)) {
-    return false;
+      remove(begin(queue->read_waiting));
+      qos_ring_copy_out(queue, (void*) task->sync_ptr, task->sync_state);
+      qos_supervisor_call_result(supervisor, task, true);
+      qos_ready_task(supervisor, task_state, task);
+      progress = true;
+    }
+
+    while (!empty(begin(queue->write_waiting))) {
+      auto task = &*begin(queue->write_waiting);
+      if (task->sync_state > queue->capacity - queue->count) {
+        break;
+      }
+
+      remove(begin(queue->write_waiting));
+      qos_ring_copy_in(queue, (const void*) task->sync_ptr, task->sync_state);
+      qos_supervisor_call_result(supervisor, task, true);
+      qos_ready_task(supervisor, task_state, task);
+      progress = true;
+    }
+  } while (progress);
+}
+
+qos_task_state_t QOS_HANDLER_MODE qos_internal_block_on_queue(qos_supervisor_t* supervisor, qos_task_scheduling_dlist_t* waiting,
+                                                             const void* data, int32_t state, qos_time_t timeout) {
+  if (timeout == 0) {
+    return QOS_TASK_RUNNING;
   }
 
-  if (!qos_acquire_mutex(&queue->mutex, timeout)) {
-    qos_release_semaphore(&queue->write_semaphore, size);
-    return false;
+  auto current_task = supervisor->current_task;
+  current_task->sync_ptr = (void*) data;
+  current_task->sync_state = state;
+
+  qos_internal_insert_scheduled_task(waiting, current_task);
+  qos_delay_task(supervisor, current_task, timeout);
+
+  return QOS_TASK_SYNC_BLOCKED;
+}
+
+static qos_task_state_t QOS_HANDLER_MODE block_on_queue(qos_supervisor_t* supervisor, qos_queue_t* queue,
+                                                        qos_task_scheduling_dlist_t* waiting,
+                                                        const void* data, int32_t size, qos_time_t timeout) {
+  auto task_state = qos_internal_block_on_queue(supervisor, waiting, data, size, timeout);
+
+  if (task_state == QOS_TASK_SYNC_BLOCKED && !queue->waited) {
+    queue->waited = true;
+    queue->next_waited = g_waited_queues[supervisor->core];
+    g_waited_queues[supervisor->core] = queue;
   }
 
-  auto copy_bytes = std::min(size, queue->capacity - queue->write_idx);
-  memcpy(&queue->buffer[queue->write_idx], data, copy_bytes);
+  return task_state;
+}
+
+qos_task_state_t QOS_HANDLER_MODE qos_internal_write_queue_supervisor(qos_supervisor_t* supervisor, qos_queue_t* queue,
+                                                                    const void* data, int32_t size, qos_time_t timeout) {
+  busy_scope busy(queue);
 
-  queue->write_idx += copy_bytes;
-  if (queue->write_idx == queue->capacity) {
-    queue->write_idx = size - copy_bytes;
-    memcpy(queue->buffer, copy_bytes + (const char*) data, queue->write_idx);
+  if (size > queue->capacity - queue->count) {
+    return block_on_queue(supervisor, queue, &queue->write_waiting, data, size, timeout);
   }
 
-  qos_release_mutex(&queue->mutex);
+  auto task_state = QOS_TASK_RUNNING;
+  qos_ring_copy_in(queue, data, size);
+  qos_current_supervisor_call_result(supervisor, true);
+  transfer_waiting(supervisor, &task_state, queue);
+  return task_state;
+}
 
-  qos_release_semaphore(&queue->read_semaphore, size);
+// Queue, data and size don't fit in registers alongside the timeout so are passed in a struct on the caller's stack.
+struct queue_call_t {
+  qos_queue_t* queue;
+  void* data;
+  int32_t size;
+};
 
-  return true;
+static qos_task_state_t QOS_HANDLER_MODE write_queue_supervisor(const queue_call_t* call, qos_time_t timeout) {
+  return qos_internal_write_queue_supervisor(qos_internal_get_supervisor(), call->queue, call->data, call->size, timeout);
+}
+
+bool qos_write_queue(qos_queue_t* queue, const void* data, int32_t size, qos_time_t timeout) {
+  assert(size >= 0 && size <= queue->capacity);
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(queue->core);
+
+  queue_call_t call = { queue, (void*) data, size };
+  return qos_call_supervisor_regs(write_queue_supervisor, &call, timeout);
+}
+
+qos_task_state_t QOS_HANDLER_MODE qos_internal_read_queue_supervisor(qos_supervisor_t* supervisor, qos_queue_t* queue,
+                                                                   void* data, int32_t size, qos_time_t timeout) {
+  busy_scope busy(queue);
+
+  if (size > queue->count) {
+    return block_on_queue(supervisor, queue, &queue->read_waiting, data, size, timeout);
+  }
+
+  auto task_state = QOS_TASK_RUNNING;
+  qos_ring_copy_out(queue, data, size);
+  qos_current_supervisor_call_result(supervisor, true);
+  transfer_waiting(supervisor, &task_state, queue);
+  return task_state;
+}
+
+static qos_task_state_t QOS_HANDLER_MODE read_queue_supervisor(const queue_call_t* call, qos_time_t timeout) {
+  return qos_internal_read_queue_supervisor(qos_internal_get_supervisor(), call->queue, call->data, call->size, timeout);
 }
 
 bool qos_read_queue(qos_queue_t* queue, void* data, int32_t size, qos_time_t timeout) {
+  assert(size >= 0 && size <= queue->capacity);
   qos_normalize_time(&timeout);
 
-  // This isn't actually needed but it reduces the number of task migrations.
-  qos_core_migrator migrator(queue->mutex.core);
+  qos_core_migrator migrator(queue->core);
+
+  queue_call_t call = { queue, data, size };
+  return qos_call_supervisor_regs(read_queue_supervisor, &call, timeout);
+}
+
+static qos_task_state_t QOS_HANDLER_MODE read_queue_many_supervisor(qos_queue_t* queue, void* data, int32_t size, int32_t max_count) {
+  auto supervisor = qos_internal_get_supervisor();
+  busy_scope busy(queue);
+
+  auto count = std::min(max_count, queue->count / size);
+  if (count == 0) {
+    return QOS_TASK_RUNNING;
+  }
+
+  auto task_state = QOS_TASK_RUNNING;
+  qos_ring_copy_out(queue, data, count * size);
+  qos_current_supervisor_call_result(supervisor, count);
+  transfer_waiting(supervisor, &task_state, queue);
+  return task_state;
+}
+
+int32_t qos_internal_read_queue_many(qos_queue_t* queue, void* data, int32_t size, int32_t max_count) {
+  assert(size > 0 && max_count > 0);
+
+  qos_core_migrator migrator(queue->core);
 
-  if (!qos_acquire_semaphore(&queue->read_semaphore, size, timeout)) {
+  return qos_call_supervisor_regs(read_queue_many_supervisor, queue, data, size, max_count);
+}
+
+static void QOS_HANDLER_MODE wake_waiting_from_isr(qos_queue_t* queue) {
+  if (queue->waited) {
+    g_accessed_from_isr[queue->core] = true;
+    scb_hw->icsr = M0PLUS_ICSR_PENDSVSET_BITS;
+  }
+}
+
+// Marks the queue busy so that a higher priority ISR fails rather than preempting the transfer. One that preempts
+// between the test and the mark completes before the transfer resumes, so the queue is only examined once marked.
+static bool QOS_HANDLER_MODE try_mark_busy_from_isr(qos_queue_t* queue) {
+  if (queue->busy) {
     return false;
   }
+  queue->busy = true;
+  __dmb();
+  return true;
+}
+
+static void QOS_HANDLER_MODE unmark_busy_from_isr(qos_queue_t* queue) {
+  __dmb();
+  queue->busy = false;
+}
+
+bool QOS_HANDLER_MODE qos_write_queue_from_isr(qos_queue_t* queue, const void* data, int32_t size) {
+  assert(queue->core == get_core_num());
+  assert(size >= 0 && size <= queue->capacity);
 
-  if (!qos_acquire_mutex(&queue->mutex, timeout)) {
-    qos_release_semaphore(&queue->write_semaphore, size);
+  if (!try_mark_busy_from_isr(queue)) {
     return false;
   }
 
-  auto copy_bytes = std::min(size, queue->capacity - queue->read_idx);
-  memcpy(data, &queue->buffer[queue->read_idx], copy_bytes);
+  auto written = size <= queue->capacity - queue->count;
+  if (written) {
+    qos_ring_copy_in(queue, data, size);
+    wake_waiting_from_isr(queue);
+  }
+
+  unmark_busy_from_isr(queue);
+  return written;
+}
 
-  queue->read_idx += copy_bytes;
-  if (queue->read_idx == queue->capacity) {
-    queue->read_idx = size - copy_bytes;
-    memcpy(copy_bytes + (char*) data, queue->buffer, queue->read_idx);
+bool QOS_HANDLER_MODE qos_read_queue_from_isr(qos_queue_t* queue, void* data, int32_t size) {
+  assert(queue->core == get_core_num());
+  assert(size >= 0 && size <= queue->capacity);
+
+  if (!try_mark_busy_from_isr(queue)) {
+    return false;
   }
 
-  qos_release_mutex(&queue->mutex);
+  auto read = size <= queue->count;
+  if (read) {
+    qos_ring_copy_out(queue, data, size);
+    wake_waiting_from_isr(queue);
+  }
 
-  qos_release_semaphore(&queue->write_semaphore, size);
+  unmark_busy_from_isr(queue);
+  return read;
+}
 
-  return true;
+void QOS_HANDLER_MODE qos_internal_handle_queues_accessed_from_isr_supervisor(qos_supervisor_t* supervisor, qos_task_state_t* task_state) {
+  auto core = supervisor->core;
+  if (!g_accessed_from_isr[core]) {
+    return;
+  }
+  g_accessed_from_isr[core] = false;
+
+  // Queues on which no task remains blocked, perhaps because they timed out, are unlinked along the way.
+  auto link = &g_waited_queues[core];
+  while (*link) {
+    auto queue = *link;
+    {
+      busy_scope busy(queue);
+      transfer_waiting(supervisor, task_state, queue);
+    }
+
+    if (empty(begin(queue->read_waiting)) && empty(begin(queue->write_waiting))) {
+      queue->waited = false;
+      *link = queue->next_waited;
+      queue->next_waited = nullptr;
+    } else {
+      link = &queue->next_waited;
+    }
+  }
 }
@@ -2,15 +2,25 @@
 #define QOS_QUEUE_H
 
 #include "base.h"
+#include "placement.h"
 
 QOS_BEGIN_EXTERN_C
 
 // Multi-producer / multi-consumer queue.
 struct qos_queue_t* qos_new_queue(int32_t capacity);
+struct qos_queue_t* qos_new_queue_placed(int32_t capacity, qos_placement_t placement);  // null if no room
 void qos_init_queue(struct qos_queue_t* queue, void* buffer, int32_t capacity);
 bool qos_write_queue(struct qos_queue_t* queue, const void* data, int32_t size, qos_time_t timeout);
 bool qos_read_queue(struct qos_queue_t* queue, void* data, int32_t size, qos_time_t timeout);
 
+// Never block. Only for queues with affinity to the ISR's core. Return false if the transfer cannot be made
+// immediately. That includes whenever the ISR preempted anything else operating on the same queue - a supervisor call,
+// PendSV completing blocked tasks' operations, a whole batch or another ISR - so callers must handle failure even when
+// the queue has room or data. Tasks only modify a queue in supervisor calls so these need not be preceded by
+// qos_roll_back_atomic_from_isr().
+bool qos_write_queue_from_isr(struct qos_queue_t* queue, const void* data, int32_t size);
+bool qos_read_queue_from_isr(struct qos_queue_t* queue, void* data, int32_t size);
+
 QOS_END_EXTERN_C
 
 #endif  // QOS_QUEUE_H
@@ -2,21 +2,51 @@
 #define QOS_QUEUE_INTERNAL_H
 
 #include "queue.h"
-#include "semaphore.internal.h"
-#include "mutex.internal.h"
+#include "task.internal.h"
 
 QOS_BEGIN_EXTERN_C
 
 typedef struct qos_queue_t {
-  qos_semaphore_t read_semaphore;
-  qos_semaphore_t write_semaphore;
-  qos_mutex_t mutex;
+  int8_t core;
   int32_t capacity;
+  qos_atomic32_t count;
   int32_t read_idx;
   int32_t write_idx;
   char *buffer;
+
+  // While blocked, a task's sync_ptr is its data buffer and its sync_state is the number of bytes to transfer.
+  qos_task_scheduling_dlist_t read_waiting;
+  qos_task_scheduling_dlist_t write_waiting;
+
+  // Set while the supervisor or an ISR modifies the queue. ISRs might preempt either so the _from_isr functions leave
+  // a busy queue alone.
+  volatile bool busy;
+
+  // Queues on which tasks have blocked are linked so that, after ISRs access them, the supervisor can complete the
+  // operations of blocked tasks.
+  bool waited;
+  struct qos_queue_t* next_waited;
 } qos_queue_t;
 
+void qos_internal_init_queue(qos_queue_t* queue, void* buffer, int32_t capacity, int32_t core);
+
+// Unless timeout is zero, blocks the current task on one of a queue's waiting lists, storing data in its sync_ptr and
+// state in its sync_state. Shared by the queue types.
+qos_task_state_t qos_internal_block_on_queue(struct qos_supervisor_t* supervisor, qos_task_scheduling_dlist_t* waiting,
+                                             const void* data, int32_t state, qos_time_t timeout);
+
+// Reads as many whole messages of the given size as are available, up to max_count, without blocking.
+int32_t qos_internal_read_queue_many(qos_queue_t* queue, void* data, int32_t size, int32_t max_count);
+
+// Supervisor side of qos_write_queue() and qos_read_queue(), also run as steps of compound supervisor calls. With zero
+// timeout, they return without blocking if the transfer cannot be made.
+qos_task_state_t qos_internal_write_queue_supervisor(struct qos_supervisor_t* supervisor, qos_queue_t* queue,
+                                                     const void* data, int32_t size, qos_time_t timeout);
+qos_task_state_t qos_internal_read_queue_supervisor(struct qos_supervisor_t* supervisor, qos_queue_t* queue,
+                                                    void* data, int32_t size, qos_time_t timeout);
+
+void qos_internal_handle_queues_accessed_from_isr_supervisor(struct qos_supervisor_t* supervisor, qos_task_state_t* task_state);
+
 QOS_END_EXTERN_C
 
 #endif  // QOS_QUEUE_INTERNAL_H
@@ -0,0 +1,63 @@
+#ifndef QOS_RING_H
+#define QOS_RING_H
+
+#include "base.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Byte ring buffer operations shared by the queues. Ring is any queue type with capacity, count, read_idx,
+// write_idx and buffer fields. Callers ensure there is room or data enough.
+
+template <typename Ring>
+static void QOS_HANDLER_MODE qos_ring_copy_in(Ring* ring, const void* data, int32_t size) {
+  auto copy_bytes = std::min(size, ring->capacity - ring->write_idx);
+  memcpy(&ring->buffer[ring->write_idx], data, copy_bytes);
+
+  ring->write_idx += copy_bytes;
+  if (ring->write_idx == ring->capacity) {
+    ring->write_idx = size - copy_bytes;
+    memcpy(ring->buffer, copy_bytes + (const char*) data, ring->write_idx);
+  }
+
+  ring->count += size;
+}
+
+// Copies size bytes without consuming them.
+template <typename Ring>
+static void QOS_HANDLER_MODE qos_ring_peek(const Ring* ring, void* data, int32_t size) {
+  auto copy_bytes = std::min(size, ring->capacity - ring->read_idx);
+  memcpy(data, &ring->buffer[ring->read_idx], copy_bytes);
+  memcpy(copy_bytes + (char*) data, ring->buffer, size - copy_bytes);
+}
+
+// Consumes size bytes without copying them.
+template <typename Ring>
+static void QOS_HANDLER_MODE qos_ring_skip(Ring* ring, int32_t size) {
+  ring->read_idx += size;
+  if (ring->read_idx >= ring->capacity) {
+    ring->read_idx -= ring->capacity;
+  }
+
+  ring->count -= size;
+}
+
+// Consumes size bytes, copying the first data_size of them to data, which may be null if data_size is zero.
+template <typename Ring>
+static void QOS_HANDLER_MODE qos_ring_copy_out(Ring* ring, void* data, int32_t data_size, int32_t size) {
+  if (data_size) {
+    auto copy_bytes = std::min(size, ring->capacity - ring->read_idx);
+    auto first_bytes = std::min(copy_bytes, data_size);
+    memcpy(data, &ring->buffer[ring->read_idx], first_bytes);
+    memcpy(first_bytes + (char*) data, ring->buffer, std::min(size - copy_bytes, data_size - first_bytes));
+  }
+
+  qos_ring_skip(ring, size);
+}
+
+template <typename Ring>
+static void QOS_HANDLER_MODE qos_ring_copy_out(Ring* ring, void* data, int32_t size) {
+  qos_ring_copy_out(ring, data, size, size);
+}
+
+#endif  // QOS_RING_H
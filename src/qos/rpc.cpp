@@ -0,0 +1,163 @@
+#include "rpc.h"
+#include "rpc.internal.h"
+
+#include "core_migrator.h"
+#include "dlist_it.h"
+#include "svc.h"
+#include "task.h"
+#include "time.h"
+
+qos_rpc_endpoint_t* QOS_INITIALIZATION qos_new_rpc_endpoint() {
+  auto endpoint = new qos_rpc_endpoint_t;
+  qos_init_rpc_endpoint(endpoint);
+  return endpoint;
+}
+
+void QOS_INITIALIZATION qos_init_rpc_endpoint(qos_rpc_endpoint_t* endpoint) {
+  endpoint->core = get_core_num();
+  qos_init_dlist(&endpoint->calling.tasks);
+  endpoint->server = nullptr;
+  endpoint->client = nullptr;
+  endpoint->server_priority = 0;
+}
+
+// Like qos_ready_task but the task runs next, ahead of other ready tasks, when the current task blocks.
+// Only used when the task's priority is at least that of the current task.
+static void QOS_HANDLER_MODE hand_off_to_task(qos_supervisor_t* supervisor, qos_task_t* task) {
+  assert(task->priority >= supervisor->current_task->priority);
+
+  if (task->sync_unblock_task_proc) {
+    task->sync_unblock_task_proc(task);
+  }
+
+  task->sync_ptr = 0;
+  task->sync_state = 0;
+  task->sync_unblock_task_proc = 0;
+
+  qos_remove_dnode(&task->timeout_node);
+
+  splice(begin(supervisor->pending), task);
+}
+
+static void QOS_HANDLER_MODE unblock_server(qos_task_t* task) {
+  auto endpoint = (qos_rpc_endpoint_t*) task->sync_ptr;
+  endpoint->server = nullptr;
+}
+
+// The server receives the client's call, which can no longer time out, and inherits its priority.
+static void QOS_HANDLER_MODE receive_call(qos_supervisor_t* supervisor, qos_rpc_endpoint_t* endpoint,
+                                          qos_task_t* server, qos_task_t* client) {
+  qos_remove_dnode(&client->scheduling_node);
+  qos_remove_dnode(&client->timeout_node);
+  endpoint->client = client;
+
+  endpoint->server_priority = server->priority;
+  if (client->priority > server->priority) {
+    server->priority = client->priority;
+  }
+
+  qos_supervisor_call_result(supervisor, server, int32_t(client->sync_ptr));
+}
+
+static qos_task_state_t QOS_HANDLER_MODE call_supervisor(qos_supervisor_t* supervisor, va_list args) {
+  auto endpoint = va_arg(args, qos_rpc_endpoint_t*);
+  auto message = va_arg(args, void*);
+  auto timeout = va_arg(args, qos_time_t);
+
+  auto current_task = supervisor->current_task;
+  current_task->sync_ptr = message;
+
+  auto server = endpoint->server;
+  if (server) {
+    receive_call(supervisor, endpoint, server, current_task);
+    hand_off_to_task(supervisor, server);
+    return QOS_TASK_SYNC_BLOCKED;
+  }
+
+  if (timeout == 0) {
+    current_task->sync_ptr = 0;
+    return QOS_TASK_RUNNING;
+  }
+
+  qos_internal_insert_scheduled_task(&endpoint->calling, current_task);
+  qos_delay_task(supervisor, current_task, timeout);
+
+  return QOS_TASK_SYNC_BLOCKED;
+}
+
+bool qos_call(qos_rpc_endpoint_t* endpoint, void* message, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(endpoint->core);
+
+  return qos_call_supervisor_va(call_supervisor, endpoint, message, timeout);
+}
+
+static qos_task_state_t QOS_HANDLER_MODE reply_and_wait_supervisor(qos_supervisor_t* supervisor, va_list args) {
+  auto endpoint = va_arg(args, qos_rpc_endpoint_t*);
+  auto reply = va_arg(args, int32_t);
+  auto wait = va_arg(args, int32_t);
+  auto timeout = va_arg(args, qos_time_t);
+
+  auto task_state = QOS_TASK_RUNNING;
+  auto current_task = supervisor->current_task;
+
+  qos_task_t* client = nullptr;
+  if (reply) {
+    client = endpoint->client;
+    assert(client);
+    endpoint->client = nullptr;
+    current_task->priority = endpoint->server_priority;
+    qos_supervisor_call_result(supervisor, client, true);
+  }
+
+  if (wait && !empty(begin(endpoint->calling))) {
+    receive_call(supervisor, endpoint, current_task, &*begin(endpoint->calling));
+    wait = false;
+  }
+
+  if (!wait || timeout == 0) {
+    if (client) {
+      qos_ready_task(supervisor, &task_state, client);
+    }
+    return task_state;
+  }
+
+  assert(endpoint->server == nullptr);
+  endpoint->server = current_task;
+  current_task->sync_ptr = endpoint;
+  current_task->sync_unblock_task_proc = unblock_server;
+  qos_delay_task(supervisor, current_task, timeout);
+
+  if (client) {
+    if (client->priority >= current_task->priority) {
+      hand_off_to_task(supervisor, client);
+    } else {
+      qos_ready_task(supervisor, &task_state, client);
+    }
+  }
+
+  return QOS_TASK_SYNC_BLOCKED;
+}
+
+void* qos_wait_call(qos_rpc_endpoint_t* endpoint, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(endpoint->core);
+
+  return (void*) qos_call_supervisor_va(reply_and_wait_supervisor, endpoint, 0, 1, timeout);
+}
+
+void* qos_reply_and_wait(qos_rpc_endpoint_t* endpoint, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  qos_core_migrator migrator(endpoint->core);
+
+  return (void*) qos_call_supervisor_va(reply_and_wait_supervisor, endpoint, 1, 1, timeout);
+}
+
+void qos_reply(qos_rpc_endpoint_t* endpoint) {
+  qos_core_migrator migrator(endpoint->core);
+
+  qos_call_supervisor_va(reply_and_wait_supervisor, endpoint, 1, 0, QOS_NO_BLOCKING);
+}
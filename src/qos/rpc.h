@@ -0,0 +1,30 @@
+#ifndef QOS_RPC_H
+#define QOS_RPC_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+// Synchronous call / reply endpoint served by one task. While a call is in progress, the server task
+// runs at no lower priority than the calling task.
+struct qos_rpc_endpoint_t* qos_new_rpc_endpoint();
+void qos_init_rpc_endpoint(struct qos_rpc_endpoint_t* endpoint);
+
+// Blocks until the server has received message and replied. message is neither copied nor owned by the
+// endpoint; the server reads the request from it and writes the reply to it. Times out only while waiting
+// for the server to receive the call.
+bool qos_call(struct qos_rpc_endpoint_t* endpoint, void* message, qos_time_t timeout);
+
+// Server: returns the message of the next call, or null on timeout.
+void* qos_wait_call(struct qos_rpc_endpoint_t* endpoint, qos_time_t timeout);
+
+// Server: completes the current call and returns the message of the next call, or null on timeout.
+// If no call is waiting, control passes directly to the replied task.
+void* qos_reply_and_wait(struct qos_rpc_endpoint_t* endpoint, qos_time_t timeout);
+
+// Server: completes the current call.
+void qos_reply(struct qos_rpc_endpoint_t* endpoint);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_RPC_H
@@ -0,0 +1,26 @@
+#ifndef QOS_RPC_INTERNAL_H
+#define QOS_RPC_INTERNAL_H
+
+#include "rpc.h"
+#include "task.internal.h"
+
+QOS_BEGIN_EXTERN_C
+
+typedef struct qos_rpc_endpoint_t {
+  int8_t core;
+
+  // Calling tasks not yet received by the server. A blocked caller's sync_ptr is its message.
+  qos_task_scheduling_dlist_t calling;
+
+  // Server task while it is blocked awaiting a call.
+  qos_task_t* server;
+
+  // Calling task received by the server and not yet replied to, which remains blocked but
+  // cannot time out. The server's priority is restored to server_priority on reply.
+  qos_task_t* client;
+  int16_t server_priority;
+} qos_rpc_endpoint_t;
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_RPC_INTERNAL_H
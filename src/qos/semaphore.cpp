@@ -10,7 +10,6 @@
 #include "time.h"
 
 #include <cassert>
-#include <cstdarg>
 
 qos_semaphore_t* QOS_INITIALIZATION qos_new_semaphore(int32_t initial_count) {
   auto semaphore = new qos_semaphore_t;
@@ -25,13 +24,10 @@ void QOS_INITIALIZATION qos_init_semaphore(qos_semaphore_t* semaphore, int32_t i
   qos_init_dlist(&semaphore->waiting.tasks);
 }
 
-static qos_task_state_t QOS_HANDLER_MODE acquire_semaphore_supervisor(qos_supervisor_t* supervisor, va_list args) {
-  auto semaphore = va_arg(args, qos_semaphore_t*);
-  auto count = va_arg(args, int32_t);
-  auto timeout = va_arg(args, qos_time_t);
-
+qos_task_state_t QOS_HANDLER_MODE qos_internal_acquire_semaphore_supervisor(qos_semaphore_t* semaphore, int32_t count, qos_time_t timeout) {
   assert(timeout != 0);
   
+  auto supervisor = qos_internal_get_supervisor();
   auto current_task = supervisor->current_task;
 
   auto old_count = semaphore->count;
@@ -65,12 +61,11 @@ bool qos_acquire_semaphore(qos_semaphore_t* semaphore, int32_t count, qos_time_t
     return false;
   }
 
-  return qos_call_supervisor_va(acquire_semaphore_supervisor, semaphore, count, timeout);
+  return qos_call_supervisor_regs(qos_internal_acquire_semaphore_supervisor, semaphore, count, timeout);
 }
 
-static qos_task_state_t QOS_HANDLER_MODE release_semaphore_supervisor(qos_supervisor_t* supervisor, va_list args) {
-  auto semaphore = va_arg(args, qos_semaphore_t*);
-  auto count = va_arg(args, int32_t);
+qos_task_state_t QOS_HANDLER_MODE qos_internal_release_semaphore_supervisor(qos_semaphore_t* semaphore, int32_t count) {
+  auto supervisor = qos_internal_get_supervisor();
   auto task_state = QOS_TASK_RUNNING;
 
   semaphore->count += count;
@@ -99,5 +94,5 @@ void qos_release_semaphore(qos_semaphore_t* semaphore, int32_t count) {
 
   qos_core_migrator migrator(semaphore->core);
 
-  qos_call_supervisor_va(release_semaphore_supervisor, semaphore, count);
+  qos_call_supervisor_regs(qos_internal_release_semaphore_supervisor, semaphore, count);
 }
@@ -10,4 +10,8 @@ typedef struct qos_semaphore_t {
   qos_task_scheduling_dlist_t waiting;
 } qos_semaphore_t;
 
+// Typed supervisor procs, also run as steps of compound supervisor calls.
+qos_task_state_t qos_internal_acquire_semaphore_supervisor(qos_semaphore_t* semaphore, int32_t count, qos_time_t timeout);
+qos_task_state_t qos_internal_release_semaphore_supervisor(qos_semaphore_t* semaphore, int32_t count);
+
 #endif  // QOS_SEMAPHORE_INTERNAL_H
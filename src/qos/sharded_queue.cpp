@@ -0,0 +1,93 @@
+#include "sharded_queue.h"
+#include "sharded_queue.internal.h"
+
+#include "atomic.h"
+#include "core_migrator.h"
+#include "queue.h"
+#include "task.h"
+#include "time.h"
+
+#include "hardware/sync.h"
+
+qos_sharded_queue_t* QOS_INITIALIZATION qos_new_sharded_queue(int32_t shard_capacity, bool ordered) {
+  auto queue = new qos_sharded_queue_t;
+  qos_init_sharded_queue(queue, new char[shard_capacity * NUM_CORES], shard_capacity, ordered);
+  return queue;
+}
+
+void QOS_INITIALIZATION qos_init_sharded_queue(qos_sharded_queue_t* queue, void* buffer, int32_t shard_capacity, bool ordered) {
+  queue->ordered = ordered;
+
+  for (auto core = 0; core < NUM_CORES; ++core) {
+    qos_internal_init_queue(&queue->shards[core], (char*) buffer + core * shard_capacity, shard_capacity, core);
+    queue->blocked_readers[core] = 0;
+
+    // Every blocked consumer on the core is readied and those that find nothing to read block again.
+    qos_init_event_with_mode(&queue->read_events[core], core, QOS_EVENT_AUTO_RESET_ALL);
+  }
+}
+
+bool qos_write_sharded_queue(qos_sharded_queue_t* queue, const void* data, int32_t size, qos_time_t timeout) {
+  int32_t core = queue->ordered ? qos_current_task()->core : get_core_num();
+
+  if (!qos_write_queue(&queue->shards[core], data, size, timeout)) {
+    return false;
+  }
+
+  // Consumers increment blocked_readers before checking each shard for messages, so either they
+  // observe this write or this observes them.
+  __dmb();
+  if (queue->blocked_readers[core]) {
+    qos_signal_event(&queue->read_events[core]);
+  } else {
+    auto remote = 1 - core;
+    if (queue->blocked_readers[remote]) {
+      qos_signal_event(&queue->read_events[remote]);
+    }
+  }
+
+  return true;
+}
+
+static int32_t read_shards(qos_sharded_queue_t* queue, int32_t core, void* data, int32_t size, int32_t max_count) {
+  auto count = qos_internal_read_queue_many(&queue->shards[core], data, size, max_count);
+  if (count) {
+    return count;
+  }
+
+  // Only migrate to the other core if its shard appears to have a message.
+  auto remote = 1 - core;
+  if (queue->shards[remote].count < size) {
+    return 0;
+  }
+
+  return qos_internal_read_queue_many(&queue->shards[remote], data, size, max_count);
+}
+
+int32_t qos_read_sharded_queue(qos_sharded_queue_t* queue, void* data, int32_t size, int32_t max_count, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  int32_t core = get_core_num();
+
+  auto count = read_shards(queue, core, data, size, max_count);
+  if (count || timeout == 0) {
+    return count;
+  }
+
+  qos_atomic_add(&queue->blocked_readers[core], 1);
+  __dmb();
+
+  for (;;) {
+    count = read_shards(queue, core, data, size, max_count);
+    if (count) {
+      break;
+    }
+
+    if (!qos_await_event(&queue->read_events[core], timeout)) {
+      break;
+    }
+  }
+
+  qos_atomic_add(&queue->blocked_readers[core], -1);
+  return count;
+}
@@ -0,0 +1,20 @@
+#ifndef QOS_SHARDED_QUEUE_H
+#define QOS_SHARDED_QUEUE_H
+
+#include "base.h"
+
+QOS_BEGIN_EXTERN_C
+
+// Multi-producer / multi-consumer queue of fixed size messages with one shard per core. Producers write to
+// the shard of the core they are running on or, if ordered, the core with which the producing task has
+// affinity. Consumers read from the shard of the core they are running on and, when it is empty, read
+// batches from the other shard. Each sharded queue uses one of the QOS_MAX_EVENTS_PER_CORE events of every core,
+// so both cores' event budgets bound how many may exist.
+struct qos_sharded_queue_t* qos_new_sharded_queue(int32_t shard_capacity, bool ordered);
+void qos_init_sharded_queue(struct qos_sharded_queue_t* queue, void* buffer, int32_t shard_capacity, bool ordered);
+bool qos_write_sharded_queue(struct qos_sharded_queue_t* queue, const void* data, int32_t size, qos_time_t timeout);
+int32_t qos_read_sharded_queue(struct qos_sharded_queue_t* queue, void* data, int32_t size, int32_t max_count, qos_time_t timeout);
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_SHARDED_QUEUE_H
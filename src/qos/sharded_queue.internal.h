@@ -0,0 +1,22 @@
+#ifndef QOS_SHARDED_QUEUE_INTERNAL_H
+#define QOS_SHARDED_QUEUE_INTERNAL_H
+
+#include "sharded_queue.h"
+
+#include "event.internal.h"
+#include "queue.internal.h"
+
+QOS_BEGIN_EXTERN_C
+
+typedef struct qos_sharded_queue_t {
+  bool ordered;
+  qos_queue_t shards[NUM_CORES];
+
+  // Consumers blocked on each core await that core's event.
+  qos_atomic32_t blocked_readers[NUM_CORES];
+  qos_event_t read_events[NUM_CORES];
+} qos_sharded_queue_t;
+
+QOS_END_EXTERN_C
+
+#endif  // QOS_SHARDED_QUEUE_INTERNAL_H
@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <cstring>
 
+typedef int32_t (*avail_proc_t)(qos_spsc_queue_t* queue, int32_t min_size);
+
 qos_spsc_queue_t* QOS_INITIALIZATION qos_new_spsc_queue(int32_t capacity, int32_t write_core, int32_t read_core) {
   auto queue = new qos_spsc_queue_t;
   qos_init_spsc_queue(queue, new char[capacity], capacity, write_core, read_core);
@@ -12,10 +14,12 @@ qos_spsc_queue_t* QOS_INITIALIZATION qos_new_spsc_queue(int32_t capacity, int32_
 }
 
 void QOS_INITIALIZATION qos_init_spsc_queue(qos_spsc_queue_t* queue, void* buffer, int32_t capacity, int32_t write_core, int32_t read_core) {
-  assert(capacity > 0);
+  assert(capacity > 1);
 
   queue->buffer = (char*) buffer;
   queue->capacity = capacity;
+  queue->contiguous = false;
+  queue->wrap_pad = capacity;
 
   if (write_core < 0) {
     write_core = get_core_num();
@@ -30,15 +34,95 @@ void QOS_INITIALIZATION qos_init_spsc_queue(qos_spsc_queue_t* queue, void* buffe
   queue->read_head = queue->read_tail = 0;
 }
 
-static int32_t QOS_HANDLER_MODE max_producer_avail(qos_spsc_queue_t* queue) {
-  auto avail = queue->read_tail - queue->write_head;
-  if (avail <= 0) {
+qos_spsc_queue_t* QOS_INITIALIZATION qos_new_contiguous_spsc_queue(int32_t capacity, int32_t write_core, int32_t read_core) {
+  auto queue = new qos_spsc_queue_t;
+  qos_init_contiguous_spsc_queue(queue, new char[capacity], capacity, write_core, read_core);
+  return queue;
+}
+
+void QOS_INITIALIZATION qos_init_contiguous_spsc_queue(qos_spsc_queue_t* queue, void* buffer, int32_t capacity, int32_t write_core, int32_t read_core) {
+  qos_init_spsc_queue(queue, buffer, capacity, write_core, read_core);
+  queue->contiguous = true;
+}
+
+static int32_t await_avail(qos_event_t* event, qos_spsc_queue_t* queue, avail_proc_t avail_proc, int32_t min_size, qos_time_t timeout) {
+  qos_normalize_time(&timeout);
+
+  int32_t avail;
+  for (;;) {
+    avail = avail_proc(queue, min_size);
+    if (avail >= min_size) {
+      break;
+    }
+
+    // Check once more after publishing intention to await.
+    if (!event->awaited) {
+      qos_internal_set_event_awaited(event, true);
+      continue;
+    }
+
+    if (!qos_await_event(event, timeout)) {
+      qos_internal_set_event_awaited(event, false);
+      return -1;
+    }
+  }
+
+  if (event->awaited) {
+    qos_internal_set_event_awaited(event, false);
+  }
+
+  return avail;
+}
+
+static void QOS_HANDLER_MODE split_spans(qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t idx, int32_t size) {
+  auto size0 = std::min(size, queue->capacity - idx);
+  spans[0].data = &queue->buffer[idx];
+  spans[0].size = size0;
+  spans[1].data = queue->buffer;
+  spans[1].size = size - size0;
+}
+
+
+//////// Producer ////////
+
+// One byte is always left unused so that a full queue can be distinguished from an empty one.
+static int32_t QOS_HANDLER_MODE max_producer_avail(qos_spsc_queue_t* queue, int32_t min_size = 0) {
+  auto avail = queue->read_tail - queue->write_head - 1;
+  if (avail < 0) {
     avail += queue->capacity;
   }
-  assert(avail <= queue->capacity);
+  assert(avail < queue->capacity);
   return avail;
 }
 
+static int32_t QOS_HANDLER_MODE contiguous_producer_avail(qos_spsc_queue_t* queue, int32_t min_size, bool* pad) {
+  auto avail = max_producer_avail(queue);
+  auto to_end = queue->capacity - queue->write_head;
+
+  *pad = false;
+  if (avail <= to_end) {
+    return avail;
+  }
+
+  // Free space wraps around the end of the buffer. Pad to the end only if that
+  // makes enough contiguous space available at the start.
+  auto from_start = avail - to_end;
+  if (to_end < min_size && from_start >= min_size) {
+    *pad = true;
+    return from_start;
+  }
+
+  return to_end;
+}
+
+static int32_t QOS_HANDLER_MODE producer_avail(qos_spsc_queue_t* queue, int32_t min_size) {
+  if (queue->contiguous) {
+    bool pad;
+    return contiguous_producer_avail(queue, min_size, &pad);
+  }
+  return max_producer_avail(queue);
+}
+
 void QOS_HANDLER_MODE internal_write_spsc_queue(qos_spsc_queue_t* queue, const void* data, int32_t size) {
   queue->write_head += size;
   if (queue->write_head >= queue->capacity) {
@@ -53,26 +137,22 @@ void QOS_HANDLER_MODE internal_write_spsc_queue(qos_spsc_queue_t* queue, const v
 }
 
 int32_t qos_write_spsc_queue(qos_spsc_queue_t* queue, const void* data, int32_t min_size, int32_t max_size, qos_time_t timeout) {
-  qos_normalize_time(&timeout);
+  assert(!queue->contiguous);
 
-  int32_t avail;
-  for (;;) {
-    avail = max_producer_avail(queue);
-    if (avail >= min_size) {
-      break;
-    }
-    if (!qos_await_event(&queue->write_event, timeout)) {
-      return -1;
-    }
+  auto avail = await_avail(&queue->write_event, queue, max_producer_avail, min_size, timeout);
+  if (avail < 0) {
+    return -1;
   }
 
   auto size = std::min(max_size, avail);
   internal_write_spsc_queue(queue, data, size);
-  qos_signal_event(&queue->read_event);
+  qos_internal_signal_awaited_event(&queue->read_event);
   return size;
 }
 
 int32_t QOS_HANDLER_MODE qos_write_spsc_queue_from_isr(qos_spsc_queue_t* queue, const void* data, int32_t min_size, int32_t max_size) {
+  assert(!queue->contiguous);
+
   auto avail = max_producer_avail(queue);
   if (avail < min_size) {
     return -1;
@@ -80,12 +160,80 @@ int32_t QOS_HANDLER_MODE qos_write_spsc_queue_from_isr(qos_spsc_queue_t* queue,
 
   auto size = std::min(max_size, avail);
   internal_write_spsc_queue(queue, data, size);
-  qos_signal_event_from_isr(&queue->read_event);
+  qos_internal_signal_awaited_event_from_isr(&queue->read_event);
+  return size;
+}
+
+static int32_t QOS_HANDLER_MODE internal_reserve_write_spsc_queue(qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size) {
+  assert(queue->write_head == queue->write_tail);
+
+  if (!queue->contiguous) {
+    auto avail = max_producer_avail(queue);
+    if (avail < min_size) {
+      return -1;
+    }
+
+    auto size = std::min(max_size, avail);
+    split_spans(queue, spans, queue->write_head, size);
+    return size;
+  }
+
+  bool pad;
+  auto avail = contiguous_producer_avail(queue, min_size, &pad);
+  if (avail < min_size) {
+    return -1;
+  }
+
+  if (pad) {
+    // The consumer observes wrap_pad before it observes write_tail wrap.
+    queue->wrap_pad = queue->write_head;
+    queue->write_head = queue->write_tail = 0;
+  }
+
+  auto size = std::min(max_size, avail);
+  spans[0].data = &queue->buffer[queue->write_head];
+  spans[0].size = size;
+  spans[1].data = queue->buffer;
+  spans[1].size = 0;
   return size;
 }
 
+static void QOS_HANDLER_MODE internal_commit_write_spsc_queue(qos_spsc_queue_t* queue, int32_t size) {
+  assert(size >= 0 && size < queue->capacity);
 
-static int32_t QOS_HANDLER_MODE max_consumer_avail(qos_spsc_queue_t* queue) {
+  auto head = queue->write_head + size;
+  if (head >= queue->capacity) {
+    head -= queue->capacity;
+  }
+  queue->write_head = queue->write_tail = head;
+}
+
+int32_t qos_reserve_write_spsc_queue(qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size, qos_time_t timeout) {
+  if (await_avail(&queue->write_event, queue, producer_avail, min_size, timeout) < 0) {
+    return -1;
+  }
+
+  return internal_reserve_write_spsc_queue(queue, spans, min_size, max_size);
+}
+
+void qos_commit_write_spsc_queue(qos_spsc_queue_t* queue, int32_t size) {
+  internal_commit_write_spsc_queue(queue, size);
+  qos_internal_signal_awaited_event(&queue->read_event);
+}
+
+int32_t QOS_HANDLER_MODE qos_reserve_write_spsc_queue_from_isr(qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size) {
+  return internal_reserve_write_spsc_queue(queue, spans, min_size, max_size);
+}
+
+void QOS_HANDLER_MODE qos_commit_write_spsc_queue_from_isr(qos_spsc_queue_t* queue, int32_t size) {
+  internal_commit_write_spsc_queue(queue, size);
+  qos_internal_signal_awaited_event_from_isr(&queue->read_event);
+}
+
+
+//////// Consumer ////////
+
+static int32_t QOS_HANDLER_MODE max_consumer_avail(qos_spsc_queue_t* queue, int32_t min_size = 0) {
   auto avail = queue->write_tail - queue->read_head;
   if (avail < 0) {
     avail += queue->capacity;
@@ -94,6 +242,30 @@ static int32_t QOS_HANDLER_MODE max_consumer_avail(qos_spsc_queue_t* queue) {
   return avail;
 }
 
+// Padding is only ever committed at read_head after all the data preceding it, so
+// when there is data available at wrap_pad, it is padding followed by data at the
+// start of the buffer.
+static bool QOS_HANDLER_MODE is_padding_avail(qos_spsc_queue_t* queue, int32_t avail) {
+  return avail > 0 && queue->read_head == queue->wrap_pad;
+}
+
+static int32_t QOS_HANDLER_MODE contiguous_consumer_avail(qos_spsc_queue_t* queue, int32_t min_size = 0) {
+  auto avail = max_consumer_avail(queue);
+  auto read_head = queue->read_head;
+  if (is_padding_avail(queue, avail)) {
+    return avail - (queue->capacity - read_head);
+  }
+
+  return std::min(avail, queue->wrap_pad - read_head);
+}
+
+static int32_t QOS_HANDLER_MODE consumer_avail(qos_spsc_queue_t* queue, int32_t min_size) {
+  if (queue->contiguous) {
+    return contiguous_consumer_avail(queue);
+  }
+  return max_consumer_avail(queue);
+}
+
 void QOS_HANDLER_MODE internal_read_spsc_queue(qos_spsc_queue_t* queue, void* data, int32_t size) {
   queue->read_head += size;
   if (queue->read_head >= queue->capacity) {
@@ -108,26 +280,22 @@ void QOS_HANDLER_MODE internal_read_spsc_queue(qos_spsc_queue_t* queue, void* da
 }
 
 int32_t qos_read_spsc_queue(qos_spsc_queue_t* queue, void* data, int32_t min_size, int32_t max_size, qos_time_t timeout) {
-  qos_normalize_time(&timeout);
+  assert(!queue->contiguous);
 
-  int32_t avail;
-  for (;;) {
-    avail = max_consumer_avail(queue);
-    if (avail >= min_size) {
-      break;
-    }
-    if (!qos_await_event(&queue->read_event, timeout)) {
-      return -1;
-    }
+  auto avail = await_avail(&queue->read_event, queue, max_consumer_avail, min_size, timeout);
+  if (avail < 0) {
+    return -1;
   }
 
   auto size = std::min(max_size, avail);
   internal_read_spsc_queue(queue, data, size);
-  qos_signal_event(&queue->write_event);
+  qos_internal_signal_awaited_event(&queue->write_event);
   return size;
 }
 
 int32_t QOS_HANDLER_MODE qos_read_spsc_queue_from_isr(qos_spsc_queue_t* queue, void* data, int32_t min_size, int32_t max_size) {
+  assert(!queue->contiguous);
+
   auto avail = max_consumer_avail(queue);
   if (avail < min_size) {
     return -1;
@@ -135,6 +303,81 @@ int32_t QOS_HANDLER_MODE qos_read_spsc_queue_from_isr(qos_spsc_queue_t* queue, v
 
   auto size = std::min(max_size, avail);
   internal_read_spsc_queue(queue, data, size);
-  qos_signal_event_from_isr(&queue->write_event);
+  qos_internal_signal_awaited_event_from_isr(&queue->write_event);
+  return size;
+}
+
+// Returns true if padding was skipped, making space available to the producer.
+static bool QOS_HANDLER_MODE internal_peek_read_spsc_queue(qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size, int32_t* size) {
+  assert(queue->read_head == queue->read_tail);
+
+  *size = -1;
+
+  if (!queue->contiguous) {
+    auto avail = max_consumer_avail(queue);
+    if (avail >= min_size) {
+      *size = std::min(max_size, avail);
+      split_spans(queue, spans, queue->read_head, *size);
+    }
+    return false;
+  }
+
+  auto avail = max_consumer_avail(queue);
+  auto skip = is_padding_avail(queue, avail);
+  if (skip) {
+    // The producer observes wrap_pad reset before it observes read_tail wrap.
+    queue->wrap_pad = queue->capacity;
+    queue->read_head = queue->read_tail = 0;
+  }
+
+  avail = contiguous_consumer_avail(queue);
+  if (avail >= min_size) {
+    *size = std::min(max_size, avail);
+    spans[0].data = &queue->buffer[queue->read_head];
+    spans[0].size = *size;
+    spans[1].data = queue->buffer;
+    spans[1].size = 0;
+  }
+
+  return skip;
+}
+
+static void QOS_HANDLER_MODE internal_release_read_spsc_queue(qos_spsc_queue_t* queue, int32_t size) {
+  assert(size >= 0 && size < queue->capacity);
+
+  auto head = queue->read_head + size;
+  if (head >= queue->capacity) {
+    head -= queue->capacity;
+  }
+  queue->read_head = queue->read_tail = head;
+}
+
+int32_t qos_peek_read_spsc_queue(qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size, qos_time_t timeout) {
+  if (await_avail(&queue->read_event, queue, consumer_avail, min_size, timeout) < 0) {
+    return -1;
+  }
+
+  int32_t size;
+  if (internal_peek_read_spsc_queue(queue, spans, min_size, max_size, &size)) {
+    qos_internal_signal_awaited_event(&queue->write_event);
+  }
   return size;
 }
+
+void qos_release_read_spsc_queue(qos_spsc_queue_t* queue, int32_t size) {
+  internal_release_read_spsc_queue(queue, size);
+  qos_internal_signal_awaited_event(&queue->write_event);
+}
+
+int32_t QOS_HANDLER_MODE qos_peek_read_spsc_queue_from_isr(qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size) {
+  int32_t size;
+  if (internal_peek_read_spsc_queue(queue, spans, min_size, max_size, &size)) {
+    qos_internal_signal_awaited_event_from_isr(&queue->write_event);
+  }
+  return size;
+}
+
+void QOS_HANDLER_MODE qos_release_read_spsc_queue_from_isr(qos_spsc_queue_t* queue, int32_t size) {
+  internal_release_read_spsc_queue(queue, size);
+  qos_internal_signal_awaited_event_from_isr(&queue->write_event);
+}
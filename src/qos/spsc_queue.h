@@ -5,14 +5,40 @@
 
 QOS_BEGIN_EXTERN_C
 
+// A region of a queue's buffer, used for zero-copy access.
+typedef struct qos_spsc_span_t {
+  void* data;
+  int32_t size;
+} qos_spsc_span_t;
+
 // Single producer / single comsumer queue. Use qos_queue_t if there are multiple producers and/or consumers.
 struct qos_spsc_queue_t* qos_new_spsc_queue(int32_t capacity, int32_t write_core, int32_t read_core);
 void qos_init_spsc_queue(struct qos_spsc_queue_t* queue, void* buffer, int32_t capacity, int32_t write_core, int32_t read_core);
 int32_t qos_write_spsc_queue(struct qos_spsc_queue_t* queue, const void* data, int32_t min_size, int32_t max_size, qos_time_t timeout);
 int32_t qos_read_spsc_queue(struct qos_spsc_queue_t* queue, void* data, int32_t min_size, int32_t max_size, qos_time_t timeout);
+
+// The _from_isr functions may run on either core.
 int32_t qos_write_spsc_queue_from_isr(struct qos_spsc_queue_t* queue, const void* data, int32_t min_size, int32_t max_size);
 int32_t qos_read_spsc_queue_from_isr(struct qos_spsc_queue_t* queue, void* data, int32_t min_size, int32_t max_size);
 
+// Zero-copy access. The producer reserves a region of the buffer, fills it and then commits some or all of it.
+// The consumer peeks at a region of the buffer and then releases some or all of it. Where a region wraps around
+// the end of the buffer, it is split into two spans, otherwise the second span is empty.
+int32_t qos_reserve_write_spsc_queue(struct qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size, qos_time_t timeout);
+void qos_commit_write_spsc_queue(struct qos_spsc_queue_t* queue, int32_t size);
+int32_t qos_peek_read_spsc_queue(struct qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size, qos_time_t timeout);
+void qos_release_read_spsc_queue(struct qos_spsc_queue_t* queue, int32_t size);
+int32_t qos_reserve_write_spsc_queue_from_isr(struct qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size);
+void qos_commit_write_spsc_queue_from_isr(struct qos_spsc_queue_t* queue, int32_t size);
+int32_t qos_peek_read_spsc_queue_from_isr(struct qos_spsc_queue_t* queue, qos_spsc_span_t spans[2], int32_t min_size, int32_t max_size);
+void qos_release_read_spsc_queue_from_isr(struct qos_spsc_queue_t* queue, int32_t size);
+
+// In a contiguous queue, reserved and peeked regions never wrap around the end of the buffer; the producer
+// instead pads the remainder of the buffer and the consumer skips the padding. Contiguous queues may only be
+// accessed through the zero-copy functions.
+struct qos_spsc_queue_t* qos_new_contiguous_spsc_queue(int32_t capacity, int32_t write_core, int32_t read_core);
+void qos_init_contiguous_spsc_queue(struct qos_spsc_queue_t* queue, void* buffer, int32_t capacity, int32_t write_core, int32_t read_core);
+
 QOS_END_EXTERN_C
 
 #endif  // QOS_SPSC_QUEUE_H
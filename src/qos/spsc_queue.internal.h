@@ -7,10 +7,14 @@
 
 typedef struct qos_spsc_queue_t {
   int32_t capacity;
+  bool contiguous;
   qos_event_t write_event;
   qos_atomic32_t write_head, write_tail;
   qos_event_t read_event;
   qos_atomic32_t read_head, read_tail;
+
+  // Contiguous queues only. Where the producer's padding starts or capacity if there is none.
+  qos_atomic32_t wrap_pad;
   char *buffer;
 } qos_spsc_queue_t;
 
@@ -1,7 +1,13 @@
 #include "io.h"
 
+#include "core_migrator.h"
+#include "event.h"
 #include "interrupt.h"
+#include "mutex.h"
+#include "spsc_queue.h"
+#include "spsc_queue.internal.h"
 #include "task.h"
+#include "time.h"
 
 #include "hardware/gpio.h"
 #include "hardware/irq.h"
@@ -10,9 +16,38 @@
 #include "hardware/sync.h"
 #include "pico/stdio/driver.h"
 
+#include <climits>
+
 static uart_hw_t* const g_uart_hws[2] = { uart0_hw, uart1_hw };
 
+// Serializes output through stdio with output from qos_stdio_uart_write_raw(), so neither is split by the other and,
+// in buffered mode, the TX queue has one producer at a time.
+static qos_mutex_t* g_out_mutexes[2];
+
+class out_lock {
+public:
+  explicit out_lock(int32_t uart_idx): mutex(g_out_mutexes[uart_idx]) {
+    qos_acquire_mutex(mutex, QOS_NO_TIMEOUT);
+  }
+
+  ~out_lock() {
+    qos_release_mutex(mutex);
+  }
+
+private:
+  qos_mutex_t* mutex;
+};
+
+// Buffered mode only.
+static qos_spsc_queue_t g_tx_queues[2];
+static qos_spsc_queue_t g_rx_queues[2];
+
+// Signalled by the ISR when it empties the TX queue while a flush waits.
+static qos_event_t* g_tx_drained_events[2];
+static volatile bool g_tx_draining[2];
+
 static void out_char(int32_t uart_idx, const char *buf, int len) {
+  out_lock lock(uart_idx);
   auto hw = g_uart_hws[uart_idx];
 
   for (auto i = 0; i < len; ++i) {
@@ -24,6 +59,7 @@ static void out_char(int32_t uart_idx, const char *buf, int len) {
 }
 
 static void out_flush(int32_t uart_idx) {
+  out_lock lock(uart_idx);
   auto hw = g_uart_hws[uart_idx];
 
   while (hw->fr & UART_UARTFR_BUSY_BITS) {
@@ -86,7 +122,146 @@ static stdio_driver_t g_drivers[2] = {
   }
 };
 
-void QOS_INITIALIZATION qos_stdio_uart_init_full(uart_inst_t *uart, int32_t baud_rate, int32_t tx_pin, int32_t rx_pin) {
+//////// Buffered mode ////////
+
+// The TX queue's consumer and RX queue's producer is this ISR.
+static void QOS_HANDLER_MODE buffered_isr(int32_t uart_idx) {
+  auto hw = g_uart_hws[uart_idx];
+  qos_roll_back_atomic_from_isr();
+
+  // Receive everything in the RX FIFO. Interrupts are raised at 1/2 full and when the line has been idle for
+  // 32 bit periods, so readers are woken once per burst rather than per character.
+  char rx_buf[32];  // RX FIFO depth
+  int32_t rx_size = 0;
+  while (rx_size < int32_t(sizeof(rx_buf)) && !(hw->fr & UART_UARTFR_RXFE_BITS)) {
+    rx_buf[rx_size++] = hw->dr;
+  }
+
+  // Characters that do not fit are dropped.
+  if (rx_size) {
+    qos_write_spsc_queue_from_isr(&g_rx_queues[uart_idx], rx_buf, 1, rx_size);
+  }
+
+  // Transmit as much as fits in the TX FIFO.
+  auto tx_queue = &g_tx_queues[uart_idx];
+  qos_spsc_span_t spans[2];
+  auto size = qos_peek_read_spsc_queue_from_isr(tx_queue, spans, 1, INT_MAX);
+
+  // Spans are only written if there is something to send.
+  int32_t sent = 0;
+  if (size > 0) {
+    for (auto& span : spans) {
+      auto data = (const char*) span.data;
+      for (auto i = 0; i < span.size && !(hw->fr & UART_UARTFR_TXFF_BITS); ++i) {
+        hw->dr = data[i];
+        ++sent;
+      }
+    }
+
+    qos_release_read_spsc_queue_from_isr(tx_queue, sent);
+  }
+
+  // Only interrupt for TX while there is more to send.
+  if (sent == size || size < 0) {
+    hw_clear_bits(&hw->imsc, UART_UARTIMSC_TXIM_BITS);
+
+    if (g_tx_draining[uart_idx]) {
+      g_tx_draining[uart_idx] = false;
+      qos_signal_event_from_isr(g_tx_drained_events[uart_idx]);
+    }
+  } else {
+    hw_set_bits(&hw->imsc, UART_UARTIMSC_TXIM_BITS);
+  }
+}
+
+static void QOS_HANDLER_MODE buffered_isr0() {
+  buffered_isr(0);
+}
+
+static void QOS_HANDLER_MODE buffered_isr1() {
+  buffered_isr(1);
+}
+
+static void buffered_out_chars(int32_t uart_idx, const char *buf, int len) {
+  out_lock lock(uart_idx);
+  auto queue = &g_tx_queues[uart_idx];
+
+  // The ISR can only be pended on the core that handles it.
+  qos_core_migrator migrator(queue->read_event.core);
+
+  while (len) {
+    // Blocks only if the TX queue is full.
+    auto size = qos_write_spsc_queue(queue, buf, 1, len, QOS_NO_TIMEOUT);
+    buf += size;
+    len -= size;
+
+    // The TX interrupt is only raised when the TX FIFO level falls, so pend the ISR to start transmission.
+    irq_set_pending(UART0_IRQ + uart_idx);
+  }
+}
+
+static void buffered_out_flush(int32_t uart_idx) {
+  out_lock lock(uart_idx);
+
+  // Holding the lock, no task adds to the TX queue, so it stays empty once the ISR has drained it. The ISR is
+  // pended in case the queue is already empty; otherwise it might not run again.
+  {
+    qos_core_migrator migrator(g_tx_queues[uart_idx].read_event.core);
+    g_tx_draining[uart_idx] = true;
+    __dmb();
+    irq_set_pending(UART0_IRQ + uart_idx);
+    qos_await_event(g_tx_drained_events[uart_idx], QOS_NO_TIMEOUT);
+  }
+
+  // The UART does not interrupt when the TX FIFO empties so poll.
+  auto hw = g_uart_hws[uart_idx];
+  while (hw->fr & UART_UARTFR_BUSY_BITS) {
+    qos_sleep(QOS_TIMEOUT_NEXT_TICK);
+  }
+}
+
+static int buffered_in_chars(int32_t uart_idx, char *buf, int len) {
+  auto size = qos_read_spsc_queue(&g_rx_queues[uart_idx], buf, 1, len, QOS_TIMEOUT_NEXT_TICK);
+  return size > 0 ? size : PICO_ERROR_NO_DATA;
+}
+
+static void buffered_out_chars0(const char *buf, int len) {
+  return buffered_out_chars(0, buf, len);
+}
+
+static void buffered_out_flush0() {
+  return buffered_out_flush(0);
+}
+
+static int buffered_in_chars0(char *buf, int len) {
+  return buffered_in_chars(0, buf, len);
+}
+
+static void buffered_out_chars1(const char *buf, int len) {
+  return buffered_out_chars(1, buf, len);
+}
+
+static void buffered_out_flush1() {
+  return buffered_out_flush(1);
+}
+
+static int buffered_in_chars1(char *buf, int len) {
+  return buffered_in_chars(1, buf, len);
+}
+
+static stdio_driver_t g_buffered_drivers[2] = {
+  {
+    .out_chars = buffered_out_chars0,
+    .out_flush = buffered_out_flush0,
+    .in_chars = buffered_in_chars0,
+  }, {
+    .out_chars = buffered_out_chars1,
+    .out_flush = buffered_out_flush1,
+    .in_chars = buffered_in_chars1,
+  }
+};
+
+static int32_t QOS_INITIALIZATION init_uart(uart_inst_t *uart, int32_t baud_rate, int32_t tx_pin, int32_t rx_pin) {
   auto hw = (uart_hw_t*) uart;
 
   uart_init(uart, baud_rate);
@@ -102,8 +277,43 @@ void QOS_INITIALIZATION qos_stdio_uart_init_full(uart_inst_t *uart, int32_t baud
     gpio_set_function(rx_pin, GPIO_FUNC_UART);
   }
 
-  int uart_idx = uart == uart0 ? 0 : 1;
+  auto uart_idx = uart == uart0 ? 0 : 1;
+  g_out_mutexes[uart_idx] = qos_new_mutex(QOS_NO_PRIORITY_CEILING);
+  return uart_idx;
+}
+
+void QOS_INITIALIZATION qos_stdio_uart_init_full(uart_inst_t *uart, int32_t baud_rate, int32_t tx_pin, int32_t rx_pin) {
+  auto uart_idx = init_uart(uart, baud_rate, tx_pin, rx_pin);
   qos_init_await_irq(UART0_IRQ + uart_idx);
 
   stdio_set_driver_enabled(&g_drivers[uart_idx], true);
 }
+
+void QOS_INITIALIZATION qos_stdio_uart_init_buffered(uart_inst_t *uart, int32_t baud_rate, int32_t tx_pin, int32_t rx_pin,
+                                                     int32_t tx_capacity, int32_t rx_capacity) {
+  auto uart_idx = init_uart(uart, baud_rate, tx_pin, rx_pin);
+  auto hw = g_uart_hws[uart_idx];
+  auto core = get_core_num();
+
+  qos_init_spsc_queue(&g_tx_queues[uart_idx], new char[tx_capacity], tx_capacity, -1, core);
+  qos_init_spsc_queue(&g_rx_queues[uart_idx], new char[rx_capacity], rx_capacity, core, -1);
+  g_tx_drained_events[uart_idx] = qos_new_event(core);
+
+  auto irq = UART0_IRQ + uart_idx;
+  irq_set_exclusive_handler(irq, uart_idx ? buffered_isr1 : buffered_isr0);
+  irq_set_priority(irq, PICO_LOWEST_IRQ_PRIORITY);
+
+  hw->imsc = UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS;
+  irq_set_enabled(irq, true);
+
+  stdio_set_driver_enabled(&g_buffered_drivers[uart_idx], true);
+}
+
+void qos_stdio_uart_write_raw(uart_inst_t *uart, const void* data, int32_t size) {
+  auto uart_idx = uart == uart0 ? 0 : 1;
+  if (g_tx_queues[uart_idx].buffer) {
+    buffered_out_chars(uart_idx, (const char*) data, size);
+  } else {
+    out_char(uart_idx, (const char*) data, size);
+  }
+}
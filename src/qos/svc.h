@@ -29,4 +29,47 @@ void qos_current_supervisor_call_result(struct qos_supervisor_t* supervisor, int
 
 QOS_END_EXTERN_C
 
+#ifdef __cplusplus
+
+#include <string.h>
+
+template <typename T>
+struct qos_internal_identity {
+  typedef T type;
+};
+
+// Bytes of r0-r3 occupied by parameters of the given types. 64-bit parameters start at an even register.
+template <typename... Params>
+constexpr int32_t qos_internal_regs_size() {
+  int32_t size = 0;
+  ((size = ((size + int32_t(alignof(Params)) - 1) & ~(int32_t(alignof(Params)) - 1)) + int32_t(sizeof(Params))), ...);
+  return size;
+}
+
+// Typed supervisor call. Arguments are passed in r0-r3, laid out as the proc expects its parameters, and the SVC
+// handler loads them from the exception frame straight into the proc's parameter registers, so nothing is marshalled
+// through va_list. Arguments must fit in r0-r3 so the proc is not passed the supervisor; it calls
+// qos_internal_get_supervisor() instead.
+template <typename... Params>
+static inline int32_t qos_call_supervisor_regs(qos_task_state_t (*proc)(Params...),
+                                               typename qos_internal_identity<Params>::type... args) {
+  static_assert(qos_internal_regs_size<Params...>() <= 16, "supervisor call arguments must fit in r0-r3");
+
+  int32_t regs[4] = {};
+  int32_t offset = 0;
+  ((offset = (offset + int32_t(alignof(Params)) - 1) & ~(int32_t(alignof(Params)) - 1),
+    memcpy((char*) regs + offset, &args, sizeof(Params)),
+    offset += sizeof(Params)), ...);
+
+  register int32_t r0 __asm__("r0") = regs[0];
+  register int32_t r1 __asm__("r1") = regs[1];
+  register int32_t r2 __asm__("r2") = regs[2];
+  register int32_t r3 __asm__("r3") = regs[3];
+  register void* r12 __asm__("r12") = (void*) proc;
+  __asm__ volatile("SVC #0" : "+l"(r0), "+l"(r1), "+l"(r2), "+l"(r3), "+r"(r12) : : "memory");
+  return r0;
+}
+
+#endif  // __cplusplus
+
 #endif  // QOS_SVC_H
@@ -3,7 +3,11 @@
 
 #include "atomic.h"
 #include "dlist_it.h"
+#include "dpc.internal.h"
 #include "event.internal.h"
+#include "heap.h"
+#include "notify.internal.h"
+#include "queue.internal.h"
 #include "svc.h"
 #include "time.h"
 
@@ -25,11 +29,11 @@
 
 
 struct supervisor_and_stack_t {
-  char exception_stack[QOS_EXCEPTION_STACK_SIZE];
+  alignas(8) char exception_stack[QOS_EXCEPTION_STACK_SIZE];
   qos_supervisor_t* supervisor;
 };
 
-static qos_supervisor_t g_supervisors[NUM_CORES];
+qos_supervisor_t g_qos_internal_supervisors[NUM_CORES];
 volatile bool g_qos_internal_started;
 
 // This can't go in qos_supervisor_t because it's a case where core A pokes core B's supervisor state.
@@ -63,14 +67,54 @@ static int32_t add_mpu_region(qos_supervisor_t* supervisor, int32_t addr, int32_
   return supervisor->next_mpu_region++;
 }
 
-static void add_stack_guard(qos_supervisor_t* supervisor, void* stack) {
+static int32_t stack_guard_rasr(void* stack) {
   // Mask out 32-byte sub-region.
-  auto addr = (intptr_t) stack;
-  addr += 31;
+  auto addr = (intptr_t) stack + 31;
   auto sdr = 0xFF ^ (1 << ((addr >> 5) & 7));
 
-  auto rasr = 0x10000000 /* XN */ | (sdr << M0PLUS_MPU_RASR_SRD_LSB) | (7 << M0PLUS_MPU_RASR_SIZE_LSB) | M0PLUS_MPU_RASR_ENABLE_BITS;  // 2^(7+1) = 256
-  add_mpu_region(supervisor, addr, rasr);
+  return 0x10000000 /* XN */ | (sdr << M0PLUS_MPU_RASR_SRD_LSB) | (7 << M0PLUS_MPU_RASR_SIZE_LSB) | M0PLUS_MPU_RASR_ENABLE_BITS;  // 2^(7+1) = 256
+}
+
+static void add_stack_guard(qos_supervisor_t* supervisor, void* stack) {
+  add_mpu_region(supervisor, (intptr_t) stack + 31, stack_guard_rasr(stack));
+}
+
+// Rather than permanently occupying an MPU region, a task's stack guard occupies the region reserved for task
+// stack guards only while the task runs. The region number differs between cores, depending on which other regions
+// are configured, so it is added on context switch rather than stored in the TCB.
+static void set_task_stack_guard(qos_task_t* task, void* stack, bool protect) {
+  task->guard_rbar = 0;
+  task->guard_rasr = 0;
+  if (protect) {
+    task->guard_rbar = ((intptr_t) stack + 31) & ~0xFF;
+    task->guard_rasr = stack_guard_rasr(stack);
+  }
+}
+
+//////// Stack usage ////////
+
+// Unused stack is filled with this pattern. Painting and scanning skip the bytes at the bottom of each stack that
+// might be covered by its 32-byte guard sub-region.
+static const int32_t STACK_PAINT = 0xDEADBEEF;
+static const int32_t STACK_GUARD_BYTES = 64;
+
+static void paint_stack(void* stack, void* end) {
+  if (!QOS_PAINT_STACKS) {
+    return;
+  }
+
+  for (auto p = (int32_t*) ((char*) stack + STACK_GUARD_BYTES); p < (int32_t*) end; ++p) {
+    *p = STACK_PAINT;
+  }
+}
+
+static int32_t get_high_water(const char* stack, int32_t stack_size) {
+  auto end = (const int32_t*) (intptr_t(stack + stack_size) & ~3);
+  auto p = (const int32_t*) (stack + STACK_GUARD_BYTES);
+  while (p < end && *p == STACK_PAINT) {
+    ++p;
+  }
+  return (const char*) end - (const char*) p;
 }
 
 static void QOS_INITIALIZATION protect_scratch_bank(qos_supervisor_t* supervisor, intptr_t base) {
@@ -98,10 +142,14 @@ static void QOS_INITIALIZATION init_mpu(qos_supervisor_t* supervisor) {
   if (protect_flash) {
     protect_flash_ram(supervisor);
   }
+
+  if (QOS_PROTECT_TASK_STACK || QOS_PROTECT_IDLE_STACK) {
+    supervisor->task_guard_mpu_region = add_mpu_region(supervisor, 0, 0);
+  }
 }
 
 static qos_supervisor_t* QOS_HANDLER_MODE get_supervisor() {
-  return &g_supervisors[get_core_num()];
+  return &g_qos_internal_supervisors[get_core_num()];
 }
 
 static void QOS_INITIALIZATION init_supervisor(qos_supervisor_t* supervisor, void* idle_stack) {
@@ -115,13 +163,16 @@ static void QOS_INITIALIZATION init_supervisor(qos_supervisor_t* supervisor, voi
   for (auto& awaiting : supervisor->awaiting_irq) {
     qos_init_dlist(&awaiting.tasks);
   }
+  qos_init_dlist(&supervisor->awaiting_notify.tasks);
 
   supervisor->next_mpu_region = QOS_FIRST_MPU_REGION;
   supervisor->flash_mpu_region = -1;
+  supervisor->task_guard_mpu_region = -1;
   
   qos_init_dnode(&supervisor->idle_task.scheduling_node);
   qos_init_dnode(&supervisor->idle_task.timeout_node);
   supervisor->idle_task.priority = -1;
+  supervisor->idle_task.core = supervisor->core;
   supervisor->current_task = &supervisor->idle_task;
   supervisor->idle_task.stack = (char*) idle_stack;
 }
@@ -134,15 +185,30 @@ static void QOS_HANDLER_MODE run_task(qos_proc_t entry) {
 }
 
 qos_task_t* QOS_INITIALIZATION qos_new_task(uint8_t priority, qos_proc_t entry, int32_t stack_size) {
-  auto task = new qos_task_t;
-  auto stack = new int32_t[(stack_size + 3) / 4];
+  return qos_new_task_placed(priority, entry, stack_size, QOS_DEFAULT_TASK_PLACEMENT);
+}
+
+// The TCB and stack are placed together, in one allocation so that a bank without room for both is left untouched.
+// The TCB follows the stack, so an overflowing stack grows away from it.
+qos_task_t* QOS_INITIALIZATION qos_new_task_placed(uint8_t priority, qos_proc_t entry, int32_t stack_size, qos_placement_t placement) {
+  auto padded_stack_size = (stack_size + 7) & ~7;
+  auto stack = (char*) qos_allocate_placed(placement, padded_stack_size + sizeof(qos_task_t));
+  if (!stack) {
+    return nullptr;
+  }
+
+  auto task = (qos_task_t*) (stack + padded_stack_size);
   qos_init_task(task, priority, entry, stack, stack_size);
   return task;
 }
 
 static void QOS_HANDLER_MODE ready_task_handler(qos_supervisor_t* supervisor, qos_task_state_t* task_state, intptr_t handler) {
-  auto task = (qos_task_t*) (handler - offsetof(qos_task_t, ready_handler));
-  qos_ready_task(supervisor, task_state, task);
+  auto task = (qos_task_t*) ((handler & ~QOS_FIFO_TAG_MASK) - offsetof(qos_task_t, ready_handler));
+  if (handler & QOS_FIFO_NOTIFY_TAG) {
+    qos_internal_ready_if_remotely_notified(supervisor, task_state, task);
+  } else {
+    qos_ready_task(supervisor, task_state, task);
+  }
 }
 
 void qos_init_task(struct qos_task_t* task, uint8_t priority, qos_proc_t entry, void* stack, int32_t stack_size) {
@@ -161,15 +227,23 @@ void qos_init_task(struct qos_task_t* task, uint8_t priority, qos_proc_t entry,
 
   task->entry = entry;
   task->priority = priority;
+  task->core = get_core_num();
   task->stack = (char*) stack;
   task->stack_size = stack_size;
   task->ready_handler = ready_task_handler;
 
-  if (QOS_PROTECT_TASK_STACK) {
-    add_stack_guard(supervisor, task->stack);
-  }
+  set_task_stack_guard(task, task->stack, QOS_PROTECT_TASK_STACK);
 
   task->sp = task->stack + stack_size - sizeof(qos_exception_frame_t);
+  paint_stack(task->stack, task->sp);
+
+  // Tasks may be initialized concurrently by several tasks on this core.
+  void* next;
+  do {
+    next = supervisor->initialized_tasks;
+    task->next_initialized_task = (qos_task_t*) next;
+  } while (qos_atomic_compare_and_set_ptr(&supervisor->initialized_tasks, next, task) != next);
+
   auto frame = (qos_exception_frame_t*) task->sp;
   frame->lr = 0;
   frame->return_addr = (void*) run_task;
@@ -212,9 +286,17 @@ static void QOS_INITIALIZATION start_core(qos_proc_t init_proc, void* idle_stack
 
   init_mpu(supervisor);
 
-  if (QOS_PROTECT_IDLE_STACK) {
-    add_stack_guard(supervisor, idle_stack);
-  }
+  set_task_stack_guard(&supervisor->idle_task, idle_stack, QOS_PROTECT_IDLE_STACK);
+
+  // The idle stack is the part of the initial main stack below the exception stack. Leave headroom below SP
+  // for paint_stack's own frame.
+  char* sp;
+  __asm__ volatile("MOV %0, SP" : "=l"(sp));
+  supervisor->idle_task.stack_size = (char*) &supervisor_and_stack - (char*) idle_stack;
+  paint_stack(idle_stack, sp - 256);
+
+  supervisor->exception_stack = supervisor_and_stack.exception_stack;
+  paint_stack(supervisor_and_stack.exception_stack, &supervisor_and_stack.supervisor);
 
   if (QOS_PROTECT_EXCEPTION_STACK) {
     add_stack_guard(supervisor, supervisor_and_stack.exception_stack);
@@ -289,20 +371,111 @@ void qos_check_stack_overflow() {
   }
 }
 
-void QOS_NOT_FLASH qos_protect_flash() {
-  auto supervisor = get_supervisor();
+int32_t qos_get_stack_high_water(qos_task_t* task) {
+  assert(QOS_PAINT_STACKS);
+  if (!task) {
+    task = qos_current_task();
+  }
+
+  return get_high_water(task->stack, task->stack_size);
+}
+
+int32_t qos_recommend_stack_size(int32_t high_water) {
+  auto size = high_water + high_water * QOS_STACK_MARGIN_PERCENT / 100 + STACK_GUARD_BYTES;
+  return (size + 7) & ~7;
+}
+
+static void add_stack_usage(qos_stack_usage_t* usage, int32_t max_usage, int32_t* count, qos_task_t* task,
+                            int8_t core, const char* stack, int32_t stack_size) {
+  if (*count < max_usage) {
+    auto& u = usage[*count];
+    u.task = task;
+    u.parent_task = nullptr;
+    u.core = core;
+    u.idle = false;
+    u.stack_size = stack_size;
+    u.high_water = get_high_water(stack, stack_size);
+    u.recommended_size = qos_recommend_stack_size(u.high_water);
+  }
+  ++*count;
+}
+
+static qos_task_t* find_parent_task(qos_task_t* parallel_task) {
+#if QOS_TASK_PARALLEL
+  for (auto& supervisor : g_qos_internal_supervisors) {
+    for (auto task = (qos_task_t*) supervisor.initialized_tasks; task; task = task->next_initialized_task) {
+      if (task->parallel_task == parallel_task) {
+        return task;
+      }
+    }
+  }
+#endif
+  return nullptr;
+}
+
+// Reports the high water mark of every task, idle and exception stack. Each core's idle and exception stacks are
+// in a scratch bank the other core might be unable to access so the calling task visits each core in turn. Returns
+// the number of stacks, which may exceed max_usage. Intended to be called from a low priority task.
+int32_t qos_get_stack_usage(qos_stack_usage_t* usage, int32_t max_usage) {
+  assert(QOS_PAINT_STACKS);
+  assert(max_usage >= 0);
+
+  int32_t original_core = get_core_num();
+  int32_t count = 0;
+  for (int32_t core = 0; core < NUM_CORES; ++core) {
+    qos_migrate_core(core);
+    auto& supervisor = g_qos_internal_supervisors[core];
+
+    auto idle_index = count;
+    add_stack_usage(usage, max_usage, &count, &supervisor.idle_task, core, supervisor.idle_task.stack,
+                    supervisor.idle_task.stack_size);
+    if (idle_index < max_usage) {
+      usage[idle_index].idle = true;
+    }
+
+    add_stack_usage(usage, max_usage, &count, nullptr, core, supervisor.exception_stack, QOS_EXCEPTION_STACK_SIZE);
+
+    for (auto task = (qos_task_t*) supervisor.initialized_tasks; task; task = task->next_initialized_task) {
+      auto index = count;
+      add_stack_usage(usage, max_usage, &count, task, task->core, task->stack, task->stack_size);
+      if (index < max_usage) {
+        usage[index].parent_task = find_parent_task(task);
+      }
+    }
+  }
+
+  qos_migrate_core(original_core);
+  return count;
+}
+
+static qos_task_state_t QOS_HANDLER_MODE set_flash_protection_supervisor(qos_supervisor_t* supervisor, void* rasr) {
   assert(supervisor->flash_mpu_region >= 0);
   mpu_hw->rnr = supervisor->flash_mpu_region;
-  mpu_hw->rasr = 0x10000000 /* XN */ | (23 << M0PLUS_MPU_RASR_SIZE_LSB) | M0PLUS_MPU_RASR_ENABLE_BITS;  // 2^(23+1) = 16MB
+  mpu_hw->rasr = (int32_t) rasr;
   mpu_hw->rnr = 0;
+  return QOS_TASK_RUNNING;
+}
+
+// Once tasks run on this core, the MPU is programmed in a supervisor call so a context switch cannot change RNR
+// between selecting the region and writing RASR. Before then, as when called from init procs, the SVC handler might
+// not be installed so the MPU is programmed directly. Tasks are distinguished by running on the process stack,
+// since the other core might already have started.
+static void QOS_NOT_FLASH set_flash_protection(int32_t rasr) {
+  int32_t control;
+  __asm__ volatile("MRS %0, CONTROL" : "=l"(control));
+  if (control & 2) {
+    qos_call_supervisor(set_flash_protection_supervisor, (void*) rasr);
+  } else {
+    set_flash_protection_supervisor(get_supervisor(), (void*) rasr);
+  }
+}
+
+void QOS_NOT_FLASH qos_protect_flash() {
+  set_flash_protection(0x10000000 /* XN */ | (23 << M0PLUS_MPU_RASR_SIZE_LSB) | M0PLUS_MPU_RASR_ENABLE_BITS);  // 2^(23+1) = 16MB
 }
 
 void QOS_NOT_FLASH qos_unprotect_flash() {
-  auto supervisor = get_supervisor();
-  assert(supervisor->flash_mpu_region >= 0);
-  mpu_hw->rnr = supervisor->flash_mpu_region;
-  mpu_hw->rasr = 0;
-  mpu_hw->rnr = 0;
+  set_flash_protection(0);
 }
 
 qos_error_t qos_get_error() {
@@ -313,9 +486,30 @@ void qos_set_error(qos_error_t error) {
   qos_current_task()->error = error;
 }
 
+// Interpolator context is stored only for tasks that use it, keeping the TCB of other tasks small.
+void qos_save_context_with_storage(uint32_t save_context, qos_interp_context_t interp_contexts[2]) {
+#if QOS_TASK_INTERP_CONTEXT
+  auto task = qos_current_task();
+  if ((save_context & QOS_SAVE_INTERP_REGS) && !task->interp_contexts) {
+    assert(interp_contexts);
+    task->interp_contexts = interp_contexts;
+  }
+#else
+  assert(!save_context);
+#endif
+}
+
 void qos_save_context(uint32_t save_context) {
+#if QOS_TASK_INTERP_CONTEXT
   auto task = qos_current_task();
-  task->save_context |= save_context;
+  if ((save_context & QOS_SAVE_INTERP_REGS) && !task->interp_contexts) {
+    auto contexts = (qos_interp_context_t*) qos_malloc(2 * sizeof(qos_interp_context_t));
+    assert(contexts);
+    qos_save_context_with_storage(save_context, contexts);
+  }
+#else
+  assert(!save_context);
+#endif
 }
 
 static qos_task_state_t QOS_HANDLER_MODE ready_busy_blocked_tasks_supervisor(qos_supervisor_t* supervisor, void*) {
@@ -379,6 +573,8 @@ qos_task_state_t QOS_HANDLER_MODE qos_supervisor_systick(qos_supervisor_t* super
   // elevate it to its original priority by readying it. This also solves the problem of how to ready it on timeout.
   auto task_state = ready_busy_blocked_tasks_supervisor(supervisor, nullptr);
 
+  qos_internal_forward_signalled_events_supervisor();
+
   auto position = begin(delayed);
   while (position != end(delayed) && position->awaken_time <= time) {
     auto task = &*position;
@@ -399,6 +595,9 @@ qos_task_state_t QOS_HANDLER_MODE qos_supervisor_pendsv(qos_supervisor_t* superv
   supervisor->pendsv_task_state = QOS_TASK_RUNNING;
 
   qos_internal_handle_signalled_events_supervisor(supervisor, &task_state);
+  qos_internal_handle_posted_dpcs_supervisor(supervisor, &task_state);
+  qos_internal_handle_queues_accessed_from_isr_supervisor(supervisor, &task_state);
+  qos_internal_handle_notified_tasks_supervisor(supervisor, &task_state);
 
   return task_state;
 }
@@ -407,8 +606,9 @@ qos_task_state_t QOS_HANDLER_MODE qos_supervisor_fifo(qos_supervisor_t* supervis
   auto task_state = QOS_TASK_RUNNING;
 
   while (multicore_fifo_rvalid()) {
-    auto handler = (qos_fifo_handler_t*) sio_hw->fifo_rd;
-    (*handler)(supervisor, &task_state, intptr_t(handler));
+    intptr_t word = sio_hw->fifo_rd;
+    auto handler = (qos_fifo_handler_t*) (word & ~QOS_FIFO_TAG_MASK);
+    (*handler)(supervisor, &task_state, word);
   }
 
   return task_state;
@@ -493,10 +693,12 @@ qos_task_t* QOS_HANDLER_MODE qos_supervisor_context_switch(qos_task_state_t new_
   assert(new_state  != QOS_TASK_RUNNING);
   assert(current_task != &idle_task || new_state == QOS_TASK_READY);
   
-  if (current_task->save_context) {
+#if QOS_TASK_INTERP_CONTEXT
+  if (current_task->interp_contexts) {
     save_interp_context(&current_task->interp_contexts[0], interp0_hw);
     save_interp_context(&current_task->interp_contexts[1], interp1_hw);
   }
+#endif
 
   if (supervisor->migrate_task) {
     sio_hw->fifo_wr = (int32_t) &supervisor->current_task->ready_handler;
@@ -526,10 +728,32 @@ qos_task_t* QOS_HANDLER_MODE qos_supervisor_context_switch(qos_task_state_t new_
   // The idle task only runs if no other task is ready.
   assert(current_task == &idle_task || !empty(begin(pending)));
 
-  if (current_task->save_context) {
+#if QOS_TASK_INTERP_CONTEXT
+  if (current_task->interp_contexts) {
     restore_interp_context(&current_task->interp_contexts[0], interp0_hw);
     restore_interp_context(&current_task->interp_contexts[1], interp1_hw);
   }
+#endif
+
+  // Constant cost: two loads and two stores. Writing RBAR with the valid bit also selects the region, so
+  // RNR is changed, which is why thread mode code never programs the MPU directly.
+  auto region = supervisor->task_guard_mpu_region;
+  if (region >= 0) {
+#if QOS_MEASURE_STACK_GUARD_CYCLES
+    int32_t before = systick_hw->cvr;
+#endif
+
+    mpu_hw->rbar = current_task->guard_rbar | M0PLUS_MPU_RBAR_VALID_BITS | region;
+    mpu_hw->rasr = current_task->guard_rasr;
+
+#if QOS_MEASURE_STACK_GUARD_CYCLES
+    // SysTick counts down; ignore samples where it reloaded in between.
+    int32_t cycles = before - (int32_t) systick_hw->cvr;
+    if (cycles > supervisor->max_stack_guard_cycles) {
+      supervisor->max_stack_guard_cycles = cycles;
+    }
+#endif
+  }
 
   supervisor->current_task = current_task;
   return current_task;
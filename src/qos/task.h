@@ -2,10 +2,13 @@
 #define QOS_TASK_H
 
 #include "base.h"
+#include "placement.h"
 
 QOS_BEGIN_EXTERN_C
 
 struct qos_task_t* qos_new_task(uint8_t priority, qos_proc_t entry, int32_t stack_size);
+// Returns null if the placement's arena has no room for the TCB and stack together.
+struct qos_task_t* qos_new_task_placed(uint8_t priority, qos_proc_t entry, int32_t stack_size, qos_placement_t placement);
 void qos_init_task(struct qos_task_t* task, uint8_t priority, qos_proc_t entry, void* stack, int32_t stack_size);
 
 void qos_start_tasks(qos_proc_t init_core0, qos_proc_t init_core1);
@@ -22,6 +25,21 @@ static inline struct qos_task_t* qos_current_task() {
 }
 
 void qos_check_stack_overflow();
+
+typedef struct qos_stack_usage_t {
+  struct qos_task_t* task;         // nullptr for a core's exception stack
+  struct qos_task_t* parent_task;  // for a parallel task, the task whose stack it was carved from
+  int8_t core;
+  bool idle;
+  int32_t stack_size;
+  int32_t high_water;              // peak bytes used
+  int32_t recommended_size;        // stack_size to pass when creating the task
+} qos_stack_usage_t;
+
+int32_t qos_get_stack_high_water(struct qos_task_t* task);
+int32_t qos_recommend_stack_size(int32_t high_water);
+int32_t qos_get_stack_usage(qos_stack_usage_t* usage, int32_t max_usage);
+
 void qos_protect_flash();
 void qos_unprotect_flash();
 
@@ -31,8 +49,20 @@ void qos_set_error(qos_error_t error);
 enum {
   QOS_SAVE_INTERP_REGS   = 0x1,
 };
+
+// Storage for one interpolator's context; a task saving QOS_SAVE_INTERP_REGS needs two.
+typedef struct qos_interp_context_t {
+  int32_t accum0, accum1;
+  int32_t base0, base1;
+  int32_t ctrl0, ctrl1;
+} qos_interp_context_t;
+
+// Allocates any storage needed with qos_malloc.
 void qos_save_context(uint32_t save_context);
 
+// Uses storage provided by the caller, which must outlive the task, so never allocates.
+void qos_save_context_with_storage(uint32_t save_context, qos_interp_context_t interp_contexts[2]);
+
 void qos_yield();
 
 int32_t qos_migrate_core(int32_t dest_core);
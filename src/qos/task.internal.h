@@ -11,6 +11,8 @@
 
 #include <stdint.h>
 
+#include "pico/platform.h"
+
 #define QOS_MAX_IRQS 32
 
 QOS_BEGIN_EXTERN_C
@@ -18,13 +20,20 @@ QOS_BEGIN_EXTERN_C
 typedef void (*qos_task_proc_t)(struct qos_task_t*);
 typedef void (*qos_fifo_handler_t)(struct qos_supervisor_t*, qos_task_state_t* task_state, intptr_t);
 
-typedef struct qos_interp_context_t {
-  int32_t accum0, accum1;
-  int32_t base0, base1;
-  int32_t ctrl0, ctrl1;
-} qos_interp_context_t;
+// Handlers are at least word aligned so the low bits of a word written to the FIFO are available as tags. The
+// handler receives the word, tags included.
+#define QOS_FIFO_TAG_MASK 3
+#define QOS_FIFO_NOTIFY_TAG 1
+
+// Serializes the supervisors of both cores accessing qos_task_t::remote_notify. Neither holds it for more than a few
+// instructions nor while it might be preempted by anything other than ISRs, which never take it.
+#define QOS_REMOTE_NOTIFY_SPINLOCK PICO_SPINLOCK_ID_OS1
 
+// Fields are ordered so that those accessed on every context switch are together at the start.
 typedef struct qos_task_t {
+  //////// Hot ////////
+
+  // Saved by context switch assembly; offsets must not change.
   void* sp;
   int32_t r4;
   int32_t r5;
@@ -35,19 +44,35 @@ typedef struct qos_task_t {
   int32_t r10;
   int32_t r11;
 
-  // Optional context.
-  uint32_t save_context;
-  qos_interp_context_t interp_contexts[2];
-
+  qos_dnode_t scheduling_node;
   int16_t priority;
+  int8_t core;
+
+  // Stack guard MPU region, programmed on context switch. guard_rbar is only the address; the region number of the
+  // core the task runs on is added then.
+  uint32_t guard_rbar;
+  uint32_t guard_rasr;
+
+#if QOS_TASK_INTERP_CONTEXT
+  // Optional context, provided to or allocated by qos_save_context().
+  qos_interp_context_t* interp_contexts;
+#endif
+
+  //////// Cold ////////
+
   qos_proc_t entry;
   char* stack;
   int32_t stack_size;
 
-  qos_dnode_t scheduling_node;
-
   qos_error_t error;
 
+  // Notification bits or count. Only modified by code running on the task's core.
+  qos_atomic32_t notify_value;
+
+  // Bits or count notified from the other core, which never modifies notify_value. Only modified by supervisors,
+  // holding QOS_REMOTE_NOTIFY_SPINLOCK; the task adds it to notify_value in thread mode.
+  volatile uint32_t remote_notify;
+
   // May be used by synchronization primitive during TASK_SYNC_BLOCKING. Must be
   // zero at all other times. sync_unblock_task_proc must be called before making
   // the task ready.
@@ -64,11 +89,16 @@ typedef struct qos_task_t {
   qos_time_t awaken_time;
   bool sleeping;
 
+#if QOS_TASK_PARALLEL
   struct qos_task_t* parallel_task;
   qos_proc_int32_t parallel_entry;
+#endif
 
-  // FIFO handlers
+  // FIFO handler. Written to the FIFO with QOS_FIFO_NOTIFY_TAG set, it readies the task only if notified.
   qos_fifo_handler_t ready_handler;
+
+  // Next in list of tasks initialized on the same core, used to enumerate tasks when reporting stack usage.
+  struct qos_task_t* next_initialized_task;
 } qos_task_t;
 
 typedef struct qos_task_scheduling_dlist_t {
@@ -90,6 +120,7 @@ typedef struct qos_supervisor_t {
   qos_task_scheduling_dlist_t busy_blocked;  // Always in descending priority order
   qos_task_scheduling_dlist_t pending;       // Always in descending priority order
   qos_task_scheduling_dlist_t awaiting_irq[QOS_MAX_IRQS];
+  qos_task_scheduling_dlist_t awaiting_notify;
   qos_task_timout_dlist_t delayed;
 
   volatile qos_task_state_t pendsv_task_state;
@@ -97,6 +128,13 @@ typedef struct qos_supervisor_t {
   
   int8_t next_mpu_region;
   int8_t flash_mpu_region;
+  int8_t task_guard_mpu_region;  // reprogrammed with the guard of each task switched to
+#if QOS_MEASURE_STACK_GUARD_CYCLES
+  int32_t max_stack_guard_cycles;
+#endif
+
+  char* exception_stack;
+  qos_atomic_ptr_t initialized_tasks;  // excludes idle task
 } qos_supervisor_t;
 
 struct qos_exception_frame_t {
@@ -110,6 +148,12 @@ struct qos_exception_frame_t {
   int32_t xpsr;
 };
 
+// For supervisor procs called with qos_call_supervisor_regs(), which are not passed the supervisor.
+static inline qos_supervisor_t* qos_internal_get_supervisor() {
+  extern qos_supervisor_t g_qos_internal_supervisors[NUM_CORES];
+  return &g_qos_internal_supervisors[get_core_num()];
+}
+
 // Insert task into linked list, maintaining descending priority order.
 void qos_internal_insert_scheduled_task(qos_task_scheduling_dlist_t* list, qos_task_t* task);
 void qos_internal_atomic_write_fifo(qos_fifo_handler_t*);
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Decodes binary log records written by the qOS log task (src/qos/log.cpp).
+
+Format strings, and the strings passed for %s conversions, are looked up by address in the ELF image of the
+firmware that produced the log.
+
+Usage: qos_log_decode.py firmware.elf [log_file]
+
+log_file defaults to stdin, so a serial device may be configured with stty and piped in.
+"""
+
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+MAX_ARGS = 4
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+class Image:
+  """Allocated sections of a little endian 32-bit ELF file."""
+
+  def __init__(self, path):
+    with open(path, "rb") as f:
+      data = f.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+      raise ValueError("not a little endian 32-bit ELF file: " + path)
+
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+
+    self.sections = []
+    for i in range(shnum):
+      _, sh_type, flags, addr, offset, size = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+      if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+        self.sections.append((addr, data[offset:offset + size]))
+
+  def string(self, addr):
+    for base, contents in self.sections:
+      if base <= addr < base + len(contents):
+        end = contents.find(b"\0", addr - base)
+        return contents[addr - base:end if end >= 0 else len(contents)].decode("utf-8", "replace")
+    return None
+
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z|j|t)?([diuxXocspfFeEgG%])")
+
+
+def format_message(image, fmt, args):
+  args = list(args)
+
+  def convert(match):
+    flags, width, precision, conv = match.groups()
+    if conv == "%":
+      return "%"
+    if not args:
+      return match.group(0)
+
+    arg = args.pop(0)
+    spec = "%" + flags + width + ("." + precision if precision else "")
+    if conv in "di":
+      return (spec + "d") % struct.unpack("<i", struct.pack("<I", arg))[0]
+    if conv == "u":
+      return (spec + "d") % arg
+    if conv in "xXo":
+      return (spec + conv) % arg
+    if conv == "c":
+      return (spec + "c") % chr(arg & 0xFF)
+    if conv == "s":
+      s = image.string(arg)
+      return (spec + "s") % (s if s is not None else "<0x%08x>" % arg)
+    if conv == "p":
+      return "0x%08x" % arg
+    return (spec + conv) % struct.unpack("<f", struct.pack("<I", arg))[0]
+
+  return CONVERSION.sub(convert, fmt)
+
+
+def read_frames(stream):
+  while True:
+    b = stream.read(1)
+    if not b:
+      return
+    if b[0] != FRAME_SYNC:
+      continue
+
+    header = stream.read(9)
+    if len(header) < 9:
+      return
+    core, num_args = header[0] >> 4, header[0] & 0xF
+    if num_args > MAX_ARGS:
+      continue
+
+    time, fmt_addr = struct.unpack("<II", header[1:])
+    payload = stream.read(num_args * 4)
+    if len(payload) < num_args * 4:
+      return
+
+    yield core, time, fmt_addr, struct.unpack("<%dI" % num_args, payload)
+
+
+def main(argv):
+  if len(argv) not in (2, 3):
+    sys.stderr.write(__doc__)
+    return 1
+
+  image = Image(argv[1])
+  stream = open(argv[2], "rb") if len(argv) == 3 else sys.stdin.buffer
+
+  for core, time, fmt_addr, args in read_frames(stream):
+    if fmt_addr == 0:
+      message = "<%d records dropped>" % args[0]
+    else:
+      fmt = image.string(fmt_addr)
+      if fmt is None:
+        # Probably resynchronizing after lost bytes.
+        continue
+      message = format_message(image, fmt, args)
+
+    sys.stdout.write("[%d %10d] %s\n" % (core, time, message.rstrip("\n")))
+    sys.stdout.flush()
+
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main(sys.argv))